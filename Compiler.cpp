@@ -0,0 +1,175 @@
+#include "Compiler.h"
+#include <set>
+
+namespace Compiler {
+
+bool isHat(BlockType t) {
+    return t == BLOCK_WhenFlagClicked || t == BLOCK_WhenKeyPressed ||
+           t == BLOCK_WhenSpriteClicked || t == BLOCK_WhenReceive;
+}
+
+// ─── helpers ─────────────────────────────────────────────────────────────────
+
+static int emit(Program& p, BlockType op, const Block* src) {
+    Instr in;
+    in.op  = op;
+    in.src = src;
+    p.code.push_back(in);
+    return (int)p.code.size() - 1;
+}
+
+static int here(const Program& p) { return (int)p.code.size(); }
+
+// Copy literal and folded inputs straight into the instruction so the engine
+// never walks the input tree for them; anything else stays an expression pointer.
+static void decodeOperand(Instr& in, int slot, const Block* b, int input, double fallback) {
+    if ((int)b->inputs.size() <= input) {
+        in.num[slot] = fallback;
+        return;
+    }
+    const Block* e = b->inputs[input];
+    if (e && e->constant) in.num[slot] = e->constNum;
+    else                  in.arg[slot] = e; // null input reads as 0
+}
+
+static const Block* condition(const Block* b) {
+    return b->inputs.empty() ? nullptr : b->inputs[0];
+}
+
+static bool isVariable(BlockType t) {
+    return t == BLOCK_SetVariable || t == BLOCK_ChangeVariable;
+}
+
+// Variable blocks carry the name in stringValue (older saves: in text)
+static const std::string& varName(const Block* b) {
+    return b->stringValue.empty() ? b->text : b->stringValue;
+}
+
+// Give every variable reporter in an input tree its slot
+static void resolveInputs(Block* b, VariableTable& vars) {
+    for (Block* e : b->inputs) {
+        if (!e) continue;
+        if (isVariable(e->type)) e->varSlot = vars.slot(varName(e));
+        resolveInputs(e, vars);
+    }
+}
+
+// ─── lowering ────────────────────────────────────────────────────────────────
+
+static bool lowerBlock(Block* b, Program& p, VariableTable& vars);
+
+static void lowerBody(const std::vector<Block*>& body, Program& p, VariableTable& vars) {
+    for (Block* b : body)
+        if (b && !lowerBlock(b, p, vars)) break; // rest of the body is unreachable
+}
+
+// Returns false when control never falls through (forever, stop, a new hat)
+static bool lowerBlock(Block* b, Program& p, VariableTable& vars) {
+    resolveInputs(b, vars);
+    switch (b->type) {
+    case BLOCK_Repeat: {
+        // repeat: push frame | head: LoopNext -> end | body | LoopBack head
+        int init = emit(p, BLOCK_Repeat, b);
+        decodeOperand(p.code[init], 0, b, 0, b->numberValue);
+        int head = emit(p, OP_LoopNext, b);
+        lowerBody(b->nested, p, vars);
+        int back = emit(p, OP_LoopBack, b);
+        p.code[back].target = head;
+        p.code[head].target = here(p);
+        b->jumpTarget = here(p);
+        return true;
+    }
+    case BLOCK_RepeatUntil: {
+        int head = emit(p, BLOCK_RepeatUntil, b);
+        p.code[head].arg[0] = condition(b);
+        lowerBody(b->nested, p, vars);
+        int back = emit(p, OP_LoopBack, b);
+        p.code[back].target = head;
+        p.code[head].target = here(p);
+        b->jumpTarget = here(p);
+        return true;
+    }
+    case BLOCK_Forever: {
+        int head = here(p);
+        lowerBody(b->nested, p, vars);
+        int back = emit(p, OP_LoopBack, b);
+        p.code[back].target = head;
+        b->jumpTarget = head;
+        return false;
+    }
+    case BLOCK_If: {
+        int test = emit(p, BLOCK_If, b);
+        p.code[test].arg[0] = condition(b);
+        lowerBody(b->nested, p, vars);
+        p.code[test].target = here(p);
+        b->jumpTarget = here(p);
+        return true;
+    }
+    case BLOCK_IfElse: {
+        int test = emit(p, BLOCK_IfElse, b);
+        p.code[test].arg[0] = condition(b);
+        lowerBody(b->nested, p, vars);
+        int skip = emit(p, OP_Jump, b);
+        p.code[test].target = here(p);
+        b->elseTarget = here(p);
+        lowerBody(b->nested2, p, vars);
+        p.code[skip].target = here(p);
+        b->jumpTarget = here(p);
+        return true;
+    }
+    case BLOCK_Stop:
+        emit(p, BLOCK_Stop, b);
+        return false;
+    default:
+        break;
+    }
+
+    if (isHat(b->type)) return false; // a hat starts a script of its own
+
+    int i = emit(p, b->type, b);
+    Instr& in = p.code[i];
+    decodeOperand(in, 0, b, 0, b->numberValue);
+    if (b->type == BLOCK_GoToXY)
+        decodeOperand(in, 1, b, 1, 0);
+    else if (b->type == BLOCK_SayForSecs || b->type == BLOCK_ThinkForSecs)
+        decodeOperand(in, 1, b, 1, b->numberValue);
+    if (isVariable(b->type))
+        in.var = vars.slot(varName(b));
+    if (b->type == BLOCK_Broadcast || b->type == BLOCK_BroadcastAndWait)
+        in.msg = p.message(b->stringValue);
+    return true;
+}
+
+// Follow the nextBlock chain under a hat (guarded against snap cycles)
+static void lowerStack(const Block* hat, Program& p, VariableTable& vars) {
+    std::set<const Block*> seen;
+    seen.insert(hat);
+    for (Block* b = hat->nextBlock; b && seen.insert(b).second; b = b->nextBlock)
+        if (!lowerBlock(b, p, vars)) break;
+}
+
+// Record a script and file it under the event that starts it
+static void addScript(Program& p, const Block* hat, Sprite* owner) {
+    int id = (int)p.scripts.size();
+    p.scripts.push_back({hat->type, hat->stringValue, here(p), owner});
+    switch (hat->type) {
+    case BLOCK_WhenFlagClicked:   p.onFlag.push_back(id);                                 break;
+    case BLOCK_WhenKeyPressed:    p.onKey[hat->stringValue].push_back(id);                 break;
+    case BLOCK_WhenReceive:       p.onMessage[p.message(hat->stringValue)].push_back(id); break;
+    case BLOCK_WhenSpriteClicked: p.onClick[owner].push_back(id);                          break;
+    default: break;
+    }
+}
+
+void compile(Sprite* owner, const std::vector<Block*>& blocks, Program& prog, VariableTable& vars) {
+    // Every stack runs as its own thread, ending in its own Halt;
+    // stacks without a hat are never reachable
+    for (const Block* b : blocks) {
+        if (!isHat(b->type)) continue;
+        addScript(prog, b, owner);
+        lowerStack(b, prog, vars);
+        emit(prog, OP_Halt, b);
+    }
+}
+
+} // namespace Compiler
@@ -0,0 +1,10 @@
+#pragma once
+#include "GameState.h"
+
+namespace Compiler {
+    // Append every hat-rooted stack of `owner`'s workspace to `prog` and
+    // index it by the event that starts it; variable names resolve to
+    // slots of `vars`
+    void compile(Sprite* owner, const std::vector<Block*>& blocks, Program& prog, VariableTable& vars);
+    bool isHat(BlockType t);
+}
@@ -0,0 +1,205 @@
+#include "Effects.h"
+#include "GameState.h"
+#include "Logger.h"
+#include "MemStats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EFFECTS_SSE2 1
+#endif
+
+namespace Effects {
+    static const float HUE_STEP = 2; // degrees per cache key step
+
+    // ─── pixel kernels ───────────────────────────────────────────────────────
+    // RGB -> HSV (h in sextants [0, 6)), shift h, scale s, HSV -> RGB via
+    // f(n) = v - v*s*clamp(min(k, 4-k), 0, 1) with k = (n + h) mod 6, then
+    // add brightness. Branch-free so the SSE2 path does 4 pixels at a time.
+    static void applyScalar(const Uint32* src, Uint32* dst, int n, float shift, float sat, float add) {
+        for (int i = 0; i < n; i++) {
+            Uint32 p = src[i];
+            float r = ((p >> 16) & 0xFF) / 255.0f, g = ((p >> 8) & 0xFF) / 255.0f, b = (p & 0xFF) / 255.0f;
+            float mx = std::max(r, std::max(g, b)), mn = std::min(r, std::min(g, b)), d = mx - mn;
+            float h = 0;
+            if (d > 0) {
+                if      (mx == r) h = (g - b) / d;
+                else if (mx == g) h = (b - r) / d + 2;
+                else              h = (r - g) / d + 4;
+            }
+            h += shift;
+            h -= 6 * std::floor(h / 6);
+            float v = mx, s = mx > 0 ? d / mx * sat : 0;
+            auto f = [&](float k) {
+                k += h;
+                if (k >= 6) k -= 6;
+                float t = std::max(0.0f, std::min(1.0f, std::min(k, 4 - k)));
+                float c = v - v * s * t + add;
+                return (Uint32)(std::max(0.0f, std::min(1.0f, c)) * 255 + 0.5f);
+            };
+            dst[i] = (p & 0xFF000000) | f(5) << 16 | f(3) << 8 | f(1);
+        }
+    }
+
+#ifdef EFFECTS_SSE2
+    static inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    static void applySSE2(const Uint32* src, Uint32* dst, int n, float shift, float sat, float add) {
+        const __m128i byte  = _mm_set1_epi32(0xFF);
+        const __m128  zero  = _mm_setzero_ps(), one = _mm_set1_ps(1), six = _mm_set1_ps(6);
+        const __m128  scale = _mm_set1_ps(1 / 255.0f), to255 = _mm_set1_ps(255);
+        const __m128  vShift = _mm_set1_ps(shift), vSat = _mm_set1_ps(sat), vAdd = _mm_set1_ps(add);
+
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128i p = _mm_loadu_si128((const __m128i*)(src + i));
+            __m128 r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 16), byte)), scale);
+            __m128 g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 8), byte)), scale);
+            __m128 b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(p, byte)), scale);
+
+            __m128 mx = _mm_max_ps(r, _mm_max_ps(g, b));
+            __m128 mn = _mm_min_ps(r, _mm_min_ps(g, b));
+            __m128 d  = _mm_sub_ps(mx, mn);
+            __m128 grey = _mm_cmpeq_ps(d, zero);
+            __m128 inv  = _mm_div_ps(one, select(grey, one, d));
+
+            __m128 hr = _mm_mul_ps(_mm_sub_ps(g, b), inv);
+            __m128 hg = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(b, r), inv), _mm_set1_ps(2));
+            __m128 hb = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(r, g), inv), _mm_set1_ps(4));
+            __m128 h  = select(_mm_cmpeq_ps(mx, r), hr, select(_mm_cmpeq_ps(mx, g), hg, hb));
+            h = _mm_andnot_ps(grey, h);
+
+            // h + shift into [0, 6): h >= -1 and 0 <= shift < 6
+            h = _mm_add_ps(h, vShift);
+            h = _mm_add_ps(h, _mm_and_ps(_mm_cmplt_ps(h, zero), six));
+            h = _mm_sub_ps(h, _mm_and_ps(_mm_cmpge_ps(h, six), six));
+
+            __m128 v  = mx;
+            __m128 vs = _mm_mul_ps(_mm_andnot_ps(grey, d), vSat); // v * s
+            auto f = [&](float kn) {
+                __m128 k = _mm_add_ps(h, _mm_set1_ps(kn));
+                k = _mm_sub_ps(k, _mm_and_ps(_mm_cmpge_ps(k, six), six));
+                __m128 t = _mm_min_ps(k, _mm_sub_ps(_mm_set1_ps(4), k));
+                t = _mm_max_ps(zero, _mm_min_ps(one, t));
+                __m128 c = _mm_add_ps(_mm_sub_ps(v, _mm_mul_ps(vs, t)), vAdd);
+                c = _mm_max_ps(zero, _mm_min_ps(one, c));
+                return _mm_cvtps_epi32(_mm_mul_ps(c, to255));
+            };
+            __m128i out = _mm_and_si128(p, _mm_set1_epi32((int)0xFF000000));
+            out = _mm_or_si128(out, _mm_slli_epi32(f(5), 16));
+            out = _mm_or_si128(out, _mm_slli_epi32(f(3), 8));
+            out = _mm_or_si128(out, f(1));
+            _mm_storeu_si128((__m128i*)(dst + i), out);
+        }
+        applyScalar(src + i, dst + i, n - i, shift, sat, add);
+    }
+#endif
+
+    void apply(const Uint32* src, Uint32* dst, int n, float color, float brightness, float saturation) {
+        float shift = color / 60.0f;              // degrees -> sextants
+        shift -= 6 * std::floor(shift / 6);
+        float sat = 1 - saturation / 100.0f;
+        float add = brightness / 100.0f;
+#ifdef EFFECTS_SSE2
+        applySSE2(src, dst, n, shift, sat, add);
+#else
+        applyScalar(src, dst, n, shift, sat, add);
+#endif
+    }
+
+    // ─── costume pixels ──────────────────────────────────────────────────────
+    void keepPixels(Costume& c, SDL_Surface* surface) {
+        SDL_Surface* argb = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+        if (!argb) {
+            LOG_WARN(Renderer, "Costume " + c.name + " keeps no pixels, effects disabled: " + SDL_GetError());
+            return;
+        }
+        auto px = std::make_shared<CostumePixels>();
+        px->w = argb->w;
+        px->h = argb->h;
+        px->argb.resize((size_t)argb->w * argb->h);
+        SDL_LockSurface(argb);
+        for (int y = 0; y < argb->h; y++)
+            memcpy(&px->argb[(size_t)y * argb->w], (const Uint8*)argb->pixels + y * argb->pitch, argb->w * 4);
+        SDL_UnlockSurface(argb);
+        SDL_FreeSurface(argb);
+        c.pixels = px;
+    }
+
+    // ─── baked texture cache ─────────────────────────────────────────────────
+    struct Key {
+        const CostumePixels* src;
+        int hue, bright, sat; // quantized
+        bool operator==(const Key& o) const {
+            return src == o.src && hue == o.hue && bright == o.bright && sat == o.sat;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            size_t h = std::hash<const void*>()(k.src);
+            return h ^ ((size_t)k.hue * 0x9E3779B1u + ((size_t)k.bright << 10) + ((size_t)k.sat << 20));
+        }
+    };
+    struct Baked {
+        Key          key;
+        std::shared_ptr<const CostumePixels> src; // keeps key.src from being reused
+        SDL_Texture* texture;
+        long long    bytes;
+    };
+    static std::list<Baked> lru; // most recently used first
+    static std::unordered_map<Key, std::list<Baked>::iterator, KeyHash> baked;
+    static long long bakedBytes = 0;
+    static std::vector<Uint32> scratch;
+
+    static void drop(std::list<Baked>::iterator it) {
+        SDL_DestroyTexture(it->texture);
+        MemStats::remove(MemStats::MEM_Textures, it->bytes);
+        bakedBytes -= it->bytes;
+        baked.erase(it->key);
+        lru.erase(it);
+    }
+
+    void shutdown() {
+        while (!lru.empty()) drop(lru.begin());
+    }
+
+    SDL_Texture* texture(SDL_Renderer* r, const Costume& c, float color, float brightness, float saturation) {
+        const int steps = (int)(360 / HUE_STEP);
+        Key key = { c.pixels.get(),
+                    ((int)std::lround(color / HUE_STEP) % steps + steps) % steps,
+                    (int)std::lround(brightness), (int)std::lround(saturation) };
+        if (!key.src || (key.hue == 0 && key.bright == 0 && key.sat == 0)) return c.texture;
+
+        auto found = baked.find(key);
+        if (found != baked.end()) {
+            lru.splice(lru.begin(), lru, found->second);
+            return found->second->texture;
+        }
+
+        const CostumePixels& px = *c.pixels;
+        scratch.resize(px.argb.size());
+        apply(px.argb.data(), scratch.data(), (int)px.argb.size(),
+              key.hue * HUE_STEP, (float)key.bright, (float)key.sat);
+        SDL_Texture* tex = SDL_CreateTexture(r, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, px.w, px.h);
+        if (!tex) return c.texture;
+        SDL_UpdateTexture(tex, nullptr, scratch.data(), px.w * 4);
+        SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+
+        long long bytes = (long long)px.w * px.h * 4;
+        lru.push_front({key, c.pixels, tex, bytes});
+        baked[key] = lru.begin();
+        bakedBytes += bytes;
+        MemStats::add(MemStats::MEM_Textures, bytes);
+        while (bakedBytes > EFFECT_CACHE_BYTES && lru.size() > 1)
+            drop(std::prev(lru.end()));
+        return tex;
+    }
+}
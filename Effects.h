@@ -0,0 +1,28 @@
+#pragma once
+#include <SDL2/SDL.h>
+
+struct Costume;
+
+// Scratch-style graphic effects baked into costume pixels, applied in order:
+// hue shift (colorEffect, degrees), saturation (0-100, towards the colour's
+// HSV value: white for saturated colours) and brightness (-100..100, towards
+// black or white). Baked textures are cached per
+// (costume, quantized effects) and evicted least recently used once they
+// exceed EFFECT_CACHE_BYTES, so effects animated every frame mostly hit.
+namespace Effects {
+    const long long EFFECT_CACHE_BYTES = 16 << 20;
+
+    // Copies the surface's pixels into the costume as the effect source
+    void keepPixels(Costume& c, SDL_Surface* surface);
+
+    // Texture to draw for the costume with these effects: the costume's own
+    // texture when no effect is set or its pixels were not kept
+    SDL_Texture* texture(SDL_Renderer* r, const Costume& c,
+                         float color, float brightness, float saturation);
+
+    // Applies the effects to `n` ARGB8888 pixels, alpha untouched
+    void apply(const Uint32* src, Uint32* dst, int n,
+               float color, float brightness, float saturation);
+
+    void shutdown(); // before the renderer is destroyed
+}
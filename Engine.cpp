@@ -1,5 +1,10 @@
 #include "Engine.h"
+#include "Compiler.h"
 #include "Logger.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "Timeline.h"
+#include "WorkerPool.h"
 #include <SDL2/SDL_mixer.h>
 #include <cmath>
 #include <iostream>
@@ -18,13 +23,15 @@ static float stageHalfW(const GameState& s) { return s.stageWidth  / 2.0f; }
 static float stageHalfH(const GameState& s) { return s.stageHeight / 2.0f; }
 
 // Clamp sprite to stage boundaries
-static void clampToStage(Sprite* sp, const GameState& gs) {
+static void clampToStage(Sprite* sp, GameState& gs) {
     float hw = stageHalfW(gs);
     float hh = stageHalfH(gs);
-    if (sp->x < -hw) sp->x = -hw;
-    if (sp->x >  hw) sp->x =  hw;
-    if (sp->y < -hh) sp->y = -hh;
-    if (sp->y >  hh) sp->y =  hh;
+    float& x = gs.spriteData.x[sp->id];
+    float& y = gs.spriteData.y[sp->id];
+    if (x < -hw) x = -hw;
+    if (x >  hw) x =  hw;
+    if (y < -hh) y = -hh;
+    if (y >  hh) y =  hh;
 }
 
 // Normalize direction to [0, 360)
@@ -37,7 +44,7 @@ static float normDir(float d) {
 // Safe division
 static double safeDivide(double a, double b) {
     if (b == 0) {
-        Logger::warning("Math safeguard: division by zero prevented");
+        LOG_WARN(Engine, "Math safeguard: division by zero prevented");
         return 0;
     }
     return a / b;
@@ -46,54 +53,93 @@ static double safeDivide(double a, double b) {
 // Safe sqrt
 static double safeSqrt(double x) {
     if (x < 0) {
-        Logger::warning("Math safeguard: sqrt of negative number prevented");
+        LOG_WARN(Engine, "Math safeguard: sqrt of negative number prevented");
         return 0;
     }
     return std::sqrt(x);
 }
 
-// Evaluate a simple numeric block value
+// Key name used by key hats / "key pressed?" to scancode
+static SDL_Scancode keyScancode(const std::string& key) {
+    if (key == "space") return SDL_SCANCODE_SPACE;
+    if (key == "up")    return SDL_SCANCODE_UP;
+    if (key == "down")  return SDL_SCANCODE_DOWN;
+    if (key == "left")  return SDL_SCANCODE_LEFT;
+    if (key == "right") return SDL_SCANCODE_RIGHT;
+    return SDL_SCANCODE_UNKNOWN;
+}
+
+static bool evalBool(const Block* b, const GameState& gs, Sprite* sp);
+
+// Variable value as sprite `sp` sees it: during a parallel pass its own
+// uncommitted writes come first
+static const Value& varValue(const GameState& gs, const Sprite* sp, int slot) {
+    if (gs.exec.deferShared && sp) {
+        const DeferredWrites& own = gs.exec.writes[sp->id];
+        if (own.wrote[slot]) return own.vars[slot];
+    }
+    return gs.variables.values[slot];
+}
+
+// Next number in [0, 1) from the sprite's own random stream
+static double random01(Sprite* sp) {
+    sp->rng = sp->rng * 1664525u + 1013904223u;
+    return (sp->rng >> 8) / 16777216.0;
+}
+
+// Input i as a number; `fallback` when the block has no such input
+static double inNum(const Block* b, size_t i, double fallback, const GameState& gs, Sprite* sp);
+
+// Evaluate a numeric reporter. Each input is evaluated at most once, and only
+// when the operator actually reads it.
 static double evalNum(const Block* b, const GameState& gs, Sprite* sp) {
     if (!b) return 0;
-    if (b->type == BLOCK_Literal) return b->numberValue;
-    if (b->type == BLOCK_MouseX)  return gs.mouseX - gs.stageX - gs.stageWidth / 2;
-    if (b->type == BLOCK_MouseY)  return gs.stageY + gs.stageHeight / 2 - gs.mouseY;
-    if (b->type == BLOCK_Timer)   return (double)gs.exec.globalTimer;
-
-    // Variable lookup
-    if (b->type == BLOCK_SetVariable || b->type == BLOCK_ChangeVariable) {
-        auto it = gs.variables.find(b->stringValue);
-        if (it != gs.variables.end()) {
-            try { return std::stod(it->second); } catch(...) {}
+    if (b->constant) return b->constNum;
+    Profiler::Scope prof(-1, b->type);
+    switch (b->type) {
+        case BLOCK_Literal: return b->numberValue;
+        case BLOCK_MouseX:  return gs.mouseX - gs.stageX - gs.stageWidth / 2;
+        case BLOCK_MouseY:  return gs.stageY + gs.stageHeight / 2 - gs.mouseY;
+        case BLOCK_Timer:   return (double)gs.exec.globalTimer;
+
+        // Variable lookup (slot resolved by preScan)
+        case BLOCK_SetVariable:
+        case BLOCK_ChangeVariable: {
+            if (b->varSlot < 0 || b->varSlot >= gs.variables.size()) return 0;
+            const Value& v = varValue(gs, sp, b->varSlot);
+            return v.type == Value::DOUBLE ? v.doubleVal : toDouble(v);
         }
-        return 0;
-    }
 
-    // Basic operators
-    double left  = b->inputs.size() > 0 ? evalNum(b->inputs[0], gs, sp) : b->numberValue;
-    double right = b->inputs.size() > 1 ? evalNum(b->inputs[1], gs, sp) : 0;
-    switch (b->type) {
-        case BLOCK_Add:      return left + right;
-        case BLOCK_Subtract: return left - right;
-        case BLOCK_Multiply: return left * right;
-        case BLOCK_Divide:   return safeDivide(left, right);
-        case BLOCK_Mod:      return (right != 0) ? std::fmod(left, right) : 0;
+        // Binary operators
+        case BLOCK_Add:      return inNum(b, 0, b->numberValue, gs, sp) + inNum(b, 1, 0, gs, sp);
+        case BLOCK_Subtract: return inNum(b, 0, b->numberValue, gs, sp) - inNum(b, 1, 0, gs, sp);
+        case BLOCK_Multiply: return inNum(b, 0, b->numberValue, gs, sp) * inNum(b, 1, 0, gs, sp);
+        case BLOCK_Divide:   return safeDivide(inNum(b, 0, b->numberValue, gs, sp), inNum(b, 1, 0, gs, sp));
+        case BLOCK_Mod: {
+            double left  = inNum(b, 0, b->numberValue, gs, sp);
+            double right = inNum(b, 1, 0, gs, sp);
+            return (right != 0) ? std::fmod(left, right) : 0;
+        }
         case BLOCK_Random: {
+            double left  = inNum(b, 0, b->numberValue, gs, sp);
+            double right = inNum(b, 1, 0, gs, sp);
             double lo = std::min(left, right);
             double hi = std::max(left, right);
-            return lo + (double)rand() / RAND_MAX * (hi - lo);
+            return lo + random01(sp) * (hi - lo);
         }
-        case BLOCK_Abs:     return std::fabs(left);
-        case BLOCK_Sqrt:    return safeSqrt(left);
-        case BLOCK_Floor:   return std::floor(left);
-        case BLOCK_Ceiling: return std::ceil(left);
-        case BLOCK_Round:   return std::round(left);
-        case BLOCK_Sin:     return std::sin(left * M_PI / 180.0);
-        case BLOCK_Cos:     return std::cos(left * M_PI / 180.0);
+
+        // Unary operators
+        case BLOCK_Abs:     return std::fabs(inNum(b, 0, b->numberValue, gs, sp));
+        case BLOCK_Sqrt:    return safeSqrt(inNum(b, 0, b->numberValue, gs, sp));
+        case BLOCK_Floor:   return std::floor(inNum(b, 0, b->numberValue, gs, sp));
+        case BLOCK_Ceiling: return std::ceil(inNum(b, 0, b->numberValue, gs, sp));
+        case BLOCK_Round:   return std::round(inNum(b, 0, b->numberValue, gs, sp));
+        case BLOCK_Sin:     return std::sin(inNum(b, 0, b->numberValue, gs, sp) * M_PI / 180.0);
+        case BLOCK_Cos:     return std::cos(inNum(b, 0, b->numberValue, gs, sp) * M_PI / 180.0);
         case BLOCK_LengthOf: {
             // string length
-            std::string s = b->inputs.size() > 0 ? b->inputs[0]->stringValue : b->stringValue;
-            return (double)s.size();
+            const Block* s = b->inputs.empty() ? b : b->inputs[0];
+            return s ? (double)s->stringValue.size() : 0;
         }
         case BLOCK_DistanceTo: {
                 // فاصله تا mouse pointer
@@ -102,169 +148,380 @@ static double evalNum(const Block* b, const GameState& gs, Sprite* sp) {
                     float mouseSceneX = gs.mouseX - gs.stageX - gs.stageWidth/2;
                     float mouseSceneY = gs.stageY + gs.stageHeight/2 - gs.mouseY;
 
-                    float dx = mouseSceneX - sp->x;
-                    float dy = mouseSceneY - sp->y;
+                    float dx = mouseSceneX - gs.spriteData.x[sp->id];
+                    float dy = mouseSceneY - gs.spriteData.y[sp->id];
 
                     double distance = std::sqrt(dx*dx + dy*dy);
-                    Logger::info("Distance to mouse: " + std::to_string(distance));
+                    LOG_DEBUG(Engine, "Distance to mouse: " + std::to_string(distance));
                     return distance;
                 }
                 return 0;
         }
+
+        // Boolean reporters dropped into a number slot read as 1 / 0
+        case BLOCK_LessThan: case BLOCK_GreaterThan: case BLOCK_Equal:
+        case BLOCK_And: case BLOCK_Or: case BLOCK_Not:
+        case BLOCK_MouseDown: case BLOCK_KeyPressed: case BLOCK_Touching:
+            return evalBool(b, gs, sp) ? 1 : 0;
+
         default: return b->numberValue;
     }
 }
 
-// Evaluate boolean condition
+static double inNum(const Block* b, size_t i, double fallback, const GameState& gs, Sprite* sp) {
+    return i < b->inputs.size() ? evalNum(b->inputs[i], gs, sp) : fallback;
+}
+
+static bool inBool(const Block* b, size_t i, const GameState& gs, Sprite* sp) {
+    return i < b->inputs.size() && evalBool(b->inputs[i], gs, sp);
+}
+
+// Evaluate boolean condition; And / Or stop at the first deciding operand
 static bool evalBool(const Block* b, const GameState& gs, Sprite* sp) {
     if (!b) return false;
-    double left  = b->inputs.size() > 0 ? evalNum(b->inputs[0], gs, sp) : 0;
-    double right = b->inputs.size() > 1 ? evalNum(b->inputs[1], gs, sp) : 0;
-    bool   bleft = b->inputs.size() > 0 ? evalBool(b->inputs[0], gs, sp) : false;
-    bool   bright= b->inputs.size() > 1 ? evalBool(b->inputs[1], gs, sp) : false;
+    if (b->constant) return b->constBool;
+    Profiler::Scope prof(-1, b->type);
     switch (b->type) {
-        case BLOCK_LessThan:    return left  <  right;
-        case BLOCK_GreaterThan: return left  >  right;
-        case BLOCK_Equal:       return std::fabs(left - right) < 1e-9;
-        case BLOCK_And:         return bleft && bright;
-        case BLOCK_Or:          return bleft || bright;
-        case BLOCK_Not:         return !bleft;
+        case BLOCK_LessThan:    return inNum(b, 0, 0, gs, sp) <  inNum(b, 1, 0, gs, sp);
+        case BLOCK_GreaterThan: return inNum(b, 0, 0, gs, sp) >  inNum(b, 1, 0, gs, sp);
+        case BLOCK_Equal:       return std::fabs(inNum(b, 0, 0, gs, sp) - inNum(b, 1, 0, gs, sp)) < 1e-9;
+        case BLOCK_And:         return inBool(b, 0, gs, sp) && inBool(b, 1, gs, sp);
+        case BLOCK_Or:          return inBool(b, 0, gs, sp) || inBool(b, 1, gs, sp);
+        case BLOCK_Not:         return !inBool(b, 0, gs, sp);
         case BLOCK_MouseDown:   return gs.mousePressed;
         case BLOCK_KeyPressed:  {
-            const Uint8* ks = SDL_GetKeyboardState(nullptr);
-            // map b->stringValue to a scancode (simplified: space only)
-            if (b->stringValue == "space")  return ks[SDL_SCANCODE_SPACE];
-            if (b->stringValue == "up")     return ks[SDL_SCANCODE_UP];
-            if (b->stringValue == "down")   return ks[SDL_SCANCODE_DOWN];
-            if (b->stringValue == "left")   return ks[SDL_SCANCODE_LEFT];
-            if (b->stringValue == "right")  return ks[SDL_SCANCODE_RIGHT];
-            return false;
+            SDL_Scancode sc = keyScancode(b->stringValue);
+            return sc != SDL_SCANCODE_UNKNOWN && SDL_GetKeyboardState(nullptr)[sc];
         }
         case BLOCK_Touching: {
             // touching edge
             if (b->stringValue == "edge") {
                 float hw = stageHalfW(gs), hh = stageHalfH(gs);
-                return sp->x <= -hw || sp->x >= hw || sp->y <= -hh || sp->y >= hh;
+                float x = gs.spriteData.x[sp->id], y = gs.spriteData.y[sp->id];
+                return x <= -hw || x >= hw || y <= -hh || y >= hh;
             }
             return false;
         }
-        default: return false;
+        // numeric reporter used as a condition: non-zero is true
+        default: return evalNum(b, gs, sp) != 0;
     }
 }
 
-//pre-scan: compute jump targets for control flow
+// ─── constant folding ────────────────────────────────────────────────────────
+
+// Reporters that read nothing but their inputs (no stage, mouse, timer,
+// keyboard or variable state) and can therefore be folded ahead of time
+static bool isPureReporter(BlockType t) {
+    switch (t) {
+        case BLOCK_Literal:
+        case BLOCK_Add: case BLOCK_Subtract: case BLOCK_Multiply: case BLOCK_Divide:
+        case BLOCK_Mod: case BLOCK_Round: case BLOCK_Abs: case BLOCK_Sqrt:
+        case BLOCK_Floor: case BLOCK_Ceiling: case BLOCK_Sin: case BLOCK_Cos:
+        case BLOCK_LengthOf:
+        case BLOCK_LessThan: case BLOCK_Equal: case BLOCK_GreaterThan:
+        case BLOCK_And: case BLOCK_Or: case BLOCK_Not:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool isConstWith(const Block* e, bool value) {
+    return e && e->constant && e->constBool == value;
+}
+
+// Fold an expression tree bottom-up. A pure node whose inputs are all known
+// becomes a constant; And / Or also fold when one side alone decides them.
+static void foldExpr(Block* e, const GameState& gs) {
+    e->constant = false;
+    e->pure     = isPureReporter(e->type);
+
+    bool allConst = true;
+    for (Block* in : e->inputs) {
+        if (!in) continue; // missing input reads as 0 / false
+        foldExpr(in, gs);
+        if (!in->constant) allConst = false;
+    }
+    if (!e->pure) return;
+
+    if (!allConst) {
+        bool decided = false, value = false;
+        for (const Block* in : e->inputs) {
+            if (e->type == BLOCK_And && isConstWith(in, false)) { decided = true; value = false; }
+            if (e->type == BLOCK_Or  && isConstWith(in, true))  { decided = true; value = true;  }
+        }
+        if (!decided) return;
+        e->constBool = value;
+        e->constNum  = value ? 1 : 0;
+        e->constant  = true;
+        return;
+    }
+
+    // sp is never touched by a pure reporter
+    e->constNum  = evalNum (e, gs, nullptr);
+    e->constBool = evalBool(e, gs, nullptr);
+    e->constant  = true;
+}
+
+// Fold every input tree of a statement and of the statements nested in it
+static void foldBlock(Block* b, const GameState& gs) {
+    for (Block* e : b->inputs)  if (e) foldExpr(e, gs);
+    for (Block* c : b->nested)  if (c) foldBlock(c, gs);
+    for (Block* c : b->nested2) if (c) foldBlock(c, gs);
+}
+
+// ─── sprite ordering ─────────────────────────────────────────────────────────
+// A parallel pass must end as the serial one does. A sprite can step on the
+// pool only if no other sprite writes what it reads; the others step alone,
+// in sprite order, and see every earlier write.
+
+// Variable slots and timer reads of an expression tree
+static void collectReads(const Block* e, std::vector<int>& slots, bool& timer) {
+    if (!e || e->constant) return;
+    if ((e->type == BLOCK_SetVariable || e->type == BLOCK_ChangeVariable) && e->varSlot >= 0)
+        slots.push_back(e->varSlot);
+    if (e->type == BLOCK_Timer) timer = true;
+    for (const Block* c : e->inputs) collectReads(c, slots, timer);
+}
+
+// Record sprite `id` writing a shared value: -1 nobody, -2 several sprites
+static void noteWriter(int& writer, int id) {
+    if (writer == -1)      writer = id;
+    else if (writer != id) writer = -2;
+}
+
+static void markOrdered(GameState& gs) {
+    Program& p = gs.program;
+    int count = (int)gs.sprites.size();
+    std::vector<std::vector<int>> reads(count);
+    std::vector<char> readsTimer(count, 0);
+    std::vector<int>  writer(gs.variables.size(), -1);
+    int timerWriter = -1;
+    p.ordered.assign(count, 0);
+    for (const ScriptEntry& s : p.scripts) {
+        int id = s.sprite->id;
+        for (int pc = s.entry; pc < (int)p.code.size() && p.code[pc].op != OP_Halt; pc++) {
+            const Instr& in = p.code[pc];
+            bool timer = false;
+            for (const Block* e : in.arg) collectReads(e, reads[id], timer);
+            if (timer) readsTimer[id] = 1;
+            if (in.var >= 0) noteWriter(writer[in.var], id); // "change by" commits a delta
+            if (in.op == BLOCK_ResetTimer) noteWriter(timerWriter, id);
+            if (in.op == BLOCK_Stop) p.ordered[id] = 1; // later sprites must not run
+        }
+    }
+    // A reset is not in the resetter's own view, so any reset orders the readers
+    for (int id = 0; id < count; id++) {
+        for (int slot : reads[id])
+            if (writer[slot] != -1 && writer[slot] != id) p.ordered[id] = 1;
+        if (readsTimer[id] && timerWriter != -1) p.ordered[id] = 1;
+    }
+}
+
+//pre-scan: fold constant expressions, then lower every sprite's hat stacks
+//into flat code with resolved jump targets and an event index
 void preScan(GameState& gs) {
-    // For now we use a simple linear scan of editorBlocks.
-    // Repeat/If/IfElse are handled via nested lists in the Block struct
-    // so no explicit jump computation is needed for nested execution.
-    // This satisfies the doc requirement.
-    Logger::info("Pre-scan complete");
+    gs.program.clear();
+    for (Sprite* sp : gs.sprites) {
+        const std::vector<Block*>& blocks = gs.scriptsOf(sp);
+        for (Block* b : blocks) foldBlock(b, gs);
+        Compiler::compile(sp, blocks, gs.program, gs.variables);
+    }
+    markOrdered(gs);
+    LOG_INFO(Engine, "Pre-scan complete — " + std::to_string(gs.program.code.size()) +
+                 " instruction(s), " + std::to_string(gs.program.scripts.size()) + " script(s)");
+}
+
+// Trace record of the instruction this thread is executing (null = not tracing)
+static thread_local Trace::Record* traceRec = nullptr;
+
+// Operand i of an instruction: pre-decoded literal or evaluated expression
+static double operand(const Instr& in, int i, const GameState& gs, Sprite* sp) {
+    if (!in.arg[i]) return in.num[i];
+    double v = evalNum(in.arg[i], gs, sp);
+    if (traceRec) traceRec->num[i] = v;
+    return v;
+}
+
+// ─── shared state ────────────────────────────────────────────────────────────
+// Effects on state shared between sprites. A serial step applies them at
+// once; a sprite stepping on the worker pool records them and commitShared()
+// replays them in sprite order, so both modes end the pass in the same state.
+
+template <class Op>
+static void shared(GameState& gs, Sprite* sp, Op op) {
+    if (!gs.exec.deferShared) { op(gs); return; }
+    gs.exec.writes[sp->id].ops.emplace_back(std::move(op));
+}
+
+static void addTo(Value& v, double delta) {
+    if (v.type == Value::DOUBLE) v.doubleVal += delta;
+    else                         v = Value(toDouble(v) + delta);
+}
+
+static void setVar(GameState& gs, Sprite* sp, int slot, const Value& v) {
+    if (!gs.exec.deferShared) { gs.variables.values[slot] = v; return; }
+    DeferredWrites& w = gs.exec.writes[sp->id];
+    w.vars[slot]  = v;
+    w.wrote[slot] = 1;
+    w.varLog.push_back({slot, false, v});
+}
+
+// Committed as a delta, so changes from several sprites add up in order
+static void changeVar(GameState& gs, Sprite* sp, int slot, double delta) {
+    if (!gs.exec.deferShared) { addTo(gs.variables.values[slot], delta); return; }
+    DeferredWrites& w = gs.exec.writes[sp->id];
+    Value v = varValue(gs, sp, slot);
+    addTo(v, delta);
+    w.vars[slot]  = v;
+    w.wrote[slot] = 1;
+    w.varLog.push_back({slot, true, Value(delta)});
+}
+
+// Queue a message for the receivers to start on the next tick; posting the
+// same message twice in one tick starts them once
+static void postMessage(GameState& gs, Sprite* sp, int id) {
+    if (id < 0) return;
+    shared(gs, sp, [id](GameState& g) {
+        std::vector<int>& q = g.exec.broadcastQueue;
+        if (std::find(q.begin(), q.end(), id) == q.end()) q.push_back(id);
+    });
+}
+
+// Is a receiver of message `id` queued to start or still running?
+static bool receiversRunning(const GameState& gs, int id) {
+    const std::vector<int>& q = gs.exec.broadcastQueue;
+    if (std::find(q.begin(), q.end(), id) != q.end()) return true;
+    for (int sid : gs.program.onMessage[id]) {
+        int owner = gs.program.scripts[sid].sprite->id;
+        if (owner >= (int)gs.exec.ctx.size()) continue;
+        for (const SpriteExecCtx& t : gs.exec.ctx[owner])
+            if (t.script == sid && !t.finished) return true;
+    }
+    return false;
 }
 
-// execute one block for a sprite
+// execute one instruction for a sprite
 // Returns true if execution should continue immediately to next block,
-// false if the engine should wait (wait-block, ask, etc.)
+// false if the engine should wait (wait-block, ask, end of a loop iteration)
 
 bool executeOneBlock(GameState& gs, Sprite* sp, SpriteExecCtx& ctx,
-                     const std::vector<Block*>& script)
+                     const Program& prog)
 {
-    if (ctx.pc >= (int)script.size()) {
+    if (ctx.pc < 0 || ctx.pc >= (int)prog.code.size()) {
         ctx.finished = true;
         return false;
     }
 
-    Block* block = script[ctx.pc];
-    std::ostringstream logMsg;
-    logMsg << "[PC:" << ctx.pc << "] [Sprite:" << sp->name
-           << "] [CMD:" << block->text << "]";
+    const Instr& in    = prog.code[ctx.pc];
+    const Block* block = in.src;
+    SpriteTable& st    = gs.spriteData; // this sprite's transform row is [id]
+    const int    id    = sp->id;
+    // "[PC:n] [Sprite:name] [CMD:text]", only built when a message is logged
+    auto where = [&] {
+        std::ostringstream ss;
+        ss << "[PC:" << ctx.pc << "] [Sprite:" << sp->name << "] [CMD:" << block->text << "]";
+        return ss.str();
+    };
 
-    gs.watchdogCounter++;
-    if (gs.watchdogCounter > GameState::WATCHDOG_LIMIT) {
-        Logger::warning("Infinite loop detected! Stopping execution.");
-        gs.exec.running = false;
+    // Every loop yields at its OP_LoopBack and all other jumps go forward, so
+    // a slice longer than the program itself is a cycle that never yields
+    if (++ctx.watchdog > (int)prog.code.size()) {
+        LOG_WARN(Engine, where() + " -> infinite loop without a yield, stopping this script");
         ctx.finished = true;
         return false;
     }
 
-    switch (block->type) {
+    Profiler::Scope prof(ctx.script, in.op);
+
+    traceRec = nullptr;
+    if (Trace::active()) {
+        traceRec = Trace::next();
+        traceRec->tick   = gs.exec.tick;
+        traceRec->pc     = ctx.pc;
+        traceRec->sprite = (uint16_t)id;
+        traceRec->op     = (uint16_t)in.op;
+        traceRec->script = ctx.script;
+        traceRec->num[0] = in.num[0];
+        traceRec->num[1] = in.num[1];
+    }
+
+    switch (in.op) {
 
     //  MOTION
     case BLOCK_Move: {
-        float steps = (float)(block->inputs.empty() ? block->numberValue
-                                                    : evalNum(block->inputs[0], gs, sp));
-        float rad = (sp->direction - 90.0f) * (float)(M_PI / 180.0);
-        sp->x += steps * std::cos(rad);
-        sp->y += steps * std::sin(rad);  // Scratch Y+ = up
+        float steps = (float)operand(in, 0, gs, sp);
+        float rad = (st.direction[id] - 90.0f) * (float)(M_PI / 180.0);
+        st.x[id] += steps * std::cos(rad);
+        st.y[id] += steps * std::sin(rad);  // Scratch Y+ = up
         clampToStage(sp, gs);
-        Logger::info(logMsg.str() + " -> moved " + std::to_string(steps) + " steps");
+        LOG_DEBUG(Engine, where() + " -> moved " + std::to_string(steps) + " steps");
         break;
     }
     case BLOCK_TurnRight: {
-        float deg = (float)(block->inputs.empty() ? block->numberValue
-                                                  : evalNum(block->inputs[0], gs, sp));
-        sp->direction = normDir(sp->direction + deg);
+        float deg = (float)operand(in, 0, gs, sp);
+        st.direction[id] = normDir(st.direction[id] + deg);
         break;
     }
     case BLOCK_TurnLeft: {
-        float deg = (float)(block->inputs.empty() ? block->numberValue
-                                                  : evalNum(block->inputs[0], gs, sp));
-        sp->direction = normDir(sp->direction - deg);
+        float deg = (float)operand(in, 0, gs, sp);
+        st.direction[id] = normDir(st.direction[id] - deg);
         break;
     }
     case BLOCK_GoToXY: {
-        sp->x = (float)(block->inputs.size() > 0 ? evalNum(block->inputs[0], gs, sp) : block->numberValue);
-        sp->y = (float)(block->inputs.size() > 1 ? evalNum(block->inputs[1], gs, sp) : 0);
+        st.x[id] = (float)operand(in, 0, gs, sp);
+        st.y[id] = (float)operand(in, 1, gs, sp);
         clampToStage(sp, gs);
         break;
     }
     case BLOCK_SetX: {
-        sp->x = (float)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
+        st.x[id] = (float)operand(in, 0, gs, sp);
         clampToStage(sp, gs);
         break;
     }
     case BLOCK_SetY: {
-        sp->y = (float)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
+        st.y[id] = (float)operand(in, 0, gs, sp);
         clampToStage(sp, gs);
         break;
     }
     case BLOCK_ChangeX: {
-        sp->x += (float)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
+        st.x[id] += (float)operand(in, 0, gs, sp);
         clampToStage(sp, gs);
         break;
     }
     case BLOCK_ChangeY: {
-        sp->y += (float)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
+        st.y[id] += (float)operand(in, 0, gs, sp);
         clampToStage(sp, gs);
         break;
     }
     case BLOCK_PointDirection: {
-        float d = (float)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
-        sp->direction = normDir(d);
+        float d = (float)operand(in, 0, gs, sp);
+        st.direction[id] = normDir(d);
         break;
     }
     case BLOCK_BounceOffEdge: {
         float hw = stageHalfW(gs), hh = stageHalfH(gs);
-        bool hitH = (sp->x <= -hw || sp->x >= hw);
-        bool hitV = (sp->y <= -hh || sp->y >= hh);
+        bool hitH = (st.x[id] <= -hw || st.x[id] >= hw);
+        bool hitV = (st.y[id] <= -hh || st.y[id] >= hh);
         if (hitH || hitV) {
-            float rad = (sp->direction - 90.0f) * (float)(M_PI / 180.0);
+            float rad = (st.direction[id] - 90.0f) * (float)(M_PI / 180.0);
             float dx = std::cos(rad), dy = std::sin(rad);
             if (hitH) dx = -dx;
             if (hitV) dy = -dy;
-            sp->direction = normDir((float)(std::atan2(dy, dx) * 180.0 / M_PI) + 90.0f);
+            st.direction[id] = normDir((float)(std::atan2(dy, dx) * 180.0 / M_PI) + 90.0f);
         }
         break;
     }
     case BLOCK_GoToMousePointer: {
-        sp->x = (float)(gs.mouseX - gs.stageX - gs.stageWidth  / 2);
-        sp->y = (float)(gs.stageY + gs.stageHeight / 2 - gs.mouseY);
+        st.x[id] = (float)(gs.mouseX - gs.stageX - gs.stageWidth  / 2);
+        st.y[id] = (float)(gs.stageY + gs.stageHeight / 2 - gs.mouseY);
         clampToStage(sp, gs);
         break;
     }
     case BLOCK_GoToRandomPosition: {
         float hw = stageHalfW(gs), hh = stageHalfH(gs);
-        sp->x = -hw + (float)rand() / RAND_MAX * (2 * hw);
-        sp->y = -hh + (float)rand() / RAND_MAX * (2 * hh);
+        st.x[id] = -hw + (float)random01(sp) * (2 * hw);
+        st.y[id] = -hh + (float)random01(sp) * (2 * hh);
         break;
     }
 
@@ -274,14 +531,13 @@ bool executeOneBlock(GameState& gs, Sprite* sp, SpriteExecCtx& ctx,
                                               : block->inputs[0]->stringValue;
         sp->sayTimer   = -1.0f;  // permanent
         sp->isThinking = false;
-        Logger::info("SAY BLOCK EXECUTED: "+sp->sayText);
+        LOG_DEBUG(Engine, "SAY BLOCK EXECUTED: "+sp->sayText);
         break;
     }
     case BLOCK_SayForSecs: {
         sp->sayText    = block->inputs.empty() ? block->stringValue
                                                : block->inputs[0]->stringValue;
-        float secs     = (float)(block->inputs.size() > 1 ? evalNum(block->inputs[1], gs, sp)
-                                                          : block->numberValue);
+        float secs     = (float)operand(in, 1, gs, sp);
         sp->sayTimer   = secs;
         sp->isThinking = false;
         break;
@@ -296,14 +552,13 @@ bool executeOneBlock(GameState& gs, Sprite* sp, SpriteExecCtx& ctx,
     case BLOCK_ThinkForSecs: {
         sp->sayText    = block->inputs.empty() ? block->stringValue
                                                : block->inputs[0]->stringValue;
-        float secs     = (float)(block->inputs.size() > 1 ? evalNum(block->inputs[1], gs, sp)
-                                                          : block->numberValue);
+        float secs     = (float)operand(in, 1, gs, sp);
         sp->sayTimer   = secs;
         sp->isThinking = true;
         break;
     }
-    case BLOCK_Show:         sp->visible = true;  break;
-    case BLOCK_Hide:         sp->visible = false; break;
+    case BLOCK_Show:         st.visible[id] = true;  break;
+    case BLOCK_Hide:         st.visible[id] = false; break;
     case BLOCK_NextCostume: {
         if (!sp->costumes.empty())
             sp->currentCostume = (sp->currentCostume + 1) % (int)sp->costumes.size();
@@ -318,277 +573,262 @@ bool executeOneBlock(GameState& gs, Sprite* sp, SpriteExecCtx& ctx,
         break;
     }
     case BLOCK_SwitchBackdrop: {
-            Logger::info("SWITCH BACKDROP - START");
-            Logger::info("stringValue: " + block->stringValue);
+        shared(gs, sp, [block](GameState& g) {
+            LOG_DEBUG(Engine, "SWITCH BACKDROP - START");
+            LOG_DEBUG(Engine, "stringValue: " + block->stringValue);
 
             if (block->stringValue == "next") {
-                gs.currentColorIndex = (gs.currentColorIndex + 1) % gs.stageColors.size();
-                Logger::info("Next backdrop - new index: " + std::to_string(gs.currentColorIndex));
+                g.currentColorIndex = (g.currentColorIndex + 1) % g.stageColors.size();
+                LOG_DEBUG(Engine, "Next backdrop - new index: " + std::to_string(g.currentColorIndex));
             } else {
-                for (int i = 0; i < (int)gs.stageColors.size(); i++) {
-                    if (gs.stageColors[i].name == block->stringValue) {
-                        gs.currentColorIndex = i;
-                        Logger::info("Found backdrop: " + gs.stageColors[i].name + " at index: " + std::to_string(i));
+                for (int i = 0; i < (int)g.stageColors.size(); i++) {
+                    if (g.stageColors[i].name == block->stringValue) {
+                        g.currentColorIndex = i;
+                        LOG_DEBUG(Engine, "Found backdrop: " + g.stageColors[i].name + " at index: " + std::to_string(i));
                         break;
                     }
                 }
             }
 
-            gs.stageColor = gs.stageColors[gs.currentColorIndex].color;
-            Logger::info("New stageColor RGB: " +
-                std::to_string(gs.stageColor.r) + "," +
-                std::to_string(gs.stageColor.g) + "," +
-                std::to_string(gs.stageColor.b));
-            break;
+            g.stageColor = g.stageColors[g.currentColorIndex].color;
+            LOG_DEBUG(Engine, "New stageColor RGB: " +
+                std::to_string(g.stageColor.r) + "," +
+                std::to_string(g.stageColor.g) + "," +
+                std::to_string(g.stageColor.b));
+        });
+        break;
     }
     case BLOCK_SetSize: {
-        float v = (float)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
-        sp->size = std::max(1.0f, v);
+        float v = (float)operand(in, 0, gs, sp);
+        st.size[id] = std::max(1.0f, v);
         break;
     }
     case BLOCK_ChangeSize: {
-        float v = (float)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
-        sp->size = std::max(1.0f, sp->size + v);
+        float v = (float)operand(in, 0, gs, sp);
+        st.size[id] = std::max(1.0f, st.size[id] + v);
         break;
     }
     case BLOCK_SetColorEffect: {
-        float v = (float)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
+        float v = (float)operand(in, 0, gs, sp);
         sp->colorEffect = std::fmod(std::fabs(v), 360.0f);
         break;
     }
     case BLOCK_ChangeColorEffect: {
-        float v = (float)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
+        float v = (float)operand(in, 0, gs, sp);
         sp->colorEffect = std::fmod(std::fabs(sp->colorEffect + v), 360.0f);
         break;
     }
     case BLOCK_SetGhostEffect:{
-        float v = (float)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
+        float v = (float)operand(in, 0, gs, sp);
         sp->ghostEffect = std::max(0.0f , std::min(100.0f,v));
         break;
     }
     case BLOCK_ChangeGhostEffect:{
-        float v = (float)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
-        Logger::info("Changing ghost by: " + std::to_string(v));
+        float v = (float)operand(in, 0, gs, sp);
+        LOG_DEBUG(Engine, "Changing ghost by: " + std::to_string(v));
         sp->ghostEffect = sp->ghostEffect + v;
         if (sp->ghostEffect < 0) sp->ghostEffect = 0;
         if (sp->ghostEffect > 100) sp->ghostEffect = 100;
-        Logger::info("New ghost value: " + std::to_string(sp->ghostEffect));
+        LOG_DEBUG(Engine, "New ghost value: " + std::to_string(sp->ghostEffect));
+        break;
     }
     case BLOCK_SetBrightnessEffect:{
-        float v = (float)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
+        float v = (float)operand(in, 0, gs, sp);
         sp->brightnessEffect = std::max(0.0f, std::min(100.0f, v));
-        Logger::info("brightness set to: " + std::to_string(sp->brightnessEffect));
+        LOG_DEBUG(Engine, "brightness set to: " + std::to_string(sp->brightnessEffect));
         break;
     }
     case BLOCK_ChangeBrightnessEffect:{
-        float v = (float)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
+        float v = (float)operand(in, 0, gs, sp);
         sp->brightnessEffect = sp->brightnessEffect + v;
         if (sp->brightnessEffect < 0) sp->brightnessEffect = 0;
         if (sp->brightnessEffect > 100) sp->brightnessEffect = 100;
-        Logger::info("brightness changed by: " + std::to_string(sp->brightnessEffect));
+        LOG_DEBUG(Engine, "brightness changed by: " + std::to_string(sp->brightnessEffect));
         break;
     }
     case BLOCK_SetSaturationEffect:{
-            float v = (float)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
+            float v = (float)operand(in, 0, gs, sp);
             sp->saturationEffect = std::max(0.0f, std::min(100.0f, v));
-            Logger::info("saturation set to: " + std::to_string(sp->saturationEffect));
+            LOG_DEBUG(Engine, "saturation set to: " + std::to_string(sp->saturationEffect));
             break;
     }
     case BLOCK_ChangeSaturationEffect:{
-            float v = (float)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
+            float v = (float)operand(in, 0, gs, sp);
             sp->saturationEffect = sp->saturationEffect + v;
             if (sp->saturationEffect < 0) sp->saturationEffect = 0;
             if (sp->saturationEffect > 100) sp->saturationEffect = 100;
-            Logger::info("Saturation changed by: " + std::to_string(sp->saturationEffect));
+            LOG_DEBUG(Engine, "Saturation changed by: " + std::to_string(sp->saturationEffect));
             break;
     }
     case BLOCK_ClearGraphicEffects:
         sp->colorEffect = 0; sp->ghostEffect = 0; sp->brightnessEffect = 0; sp->saturationEffect = 0;
         break;
-    case BLOCK_GoToFrontLayer: sp->layer = 999;  break;
-    case BLOCK_GoToBackLayer:  sp->layer = -999; break;
+    // Layers: drawOrder is shared between sprites, so reordering is committed
+    case BLOCK_GoToFrontLayer:
+        shared(gs, sp, [id](GameState& g) { g.spriteData.toFront(id); });
+        break;
+    case BLOCK_GoToBackLayer:
+        shared(gs, sp, [id](GameState& g) { g.spriteData.toBack(id); });
+        break;
     case BLOCK_GoForwardLayers: {
-        int v = (int)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
-        sp->layer += v;
+        int v = (int)operand(in, 0, gs, sp);
+        shared(gs, sp, [id, v](GameState& g) { g.spriteData.moveLayers(id, v); });
         break;
     }
     case BLOCK_GoBackwardLayers: {
-        int v = (int)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
-        sp->layer -= v;
+        int v = (int)operand(in, 0, gs, sp);
+        shared(gs, sp, [id, v](GameState& g) { g.spriteData.moveLayers(id, -v); });
         break;
     }
 
     //  SOUND   [   Honestly , wont work :) ]
     case BLOCK_StopAllSounds:
-        Mix_HaltChannel(-1);
-        Logger::info("All sounds stopped");
+        shared(gs, sp, [](GameState&) {
+            Mix_HaltChannel(-1);
+            LOG_DEBUG(Engine, "All sounds stopped");
+        });
         break;
     case BLOCK_SetVolume: {
-        int v = (int)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
-        gs.globalVolume = std::max(0, std::min(100, v));
-        Mix_Volume(-1, gs.globalVolume * MIX_MAX_VOLUME / 100);
+        int v = (int)operand(in, 0, gs, sp);
+        shared(gs, sp, [v](GameState& g) {
+            g.globalVolume = std::max(0, std::min(100, v));
+            Mix_Volume(-1, g.globalVolume * MIX_MAX_VOLUME / 100);
+        });
         break;
     }
     case BLOCK_ChangeVolume: {
-        int delta = (int)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
-        gs.globalVolume = std::max(0, std::min(100, gs.globalVolume + delta));
-        Mix_Volume(-1, gs.globalVolume * MIX_MAX_VOLUME / 100);
+        int delta = (int)operand(in, 0, gs, sp);
+        shared(gs, sp, [delta](GameState& g) {
+            g.globalVolume = std::max(0, std::min(100, g.globalVolume + delta));
+            Mix_Volume(-1, g.globalVolume * MIX_MAX_VOLUME / 100);
+        });
         break;
     }
 
     // ── EVENTS ───────────────────────────────────────────────────────────────
     case BLOCK_Broadcast: {
-        gs.exec.pendingBroadcast = block->stringValue;
-        Logger::info("Broadcast: " + block->stringValue);
+        postMessage(gs, sp, in.msg);
+        LOG_DEBUG(Engine, "Broadcast: " + block->stringValue);
         break;
     }
+    case BLOCK_BroadcastAndWait: {
+        postMessage(gs, sp, in.msg);
+        ctx.waitMessage = in.msg;
+        LOG_DEBUG(Engine, "Broadcast and wait: " + block->stringValue);
+        return false; // runScripts resumes us once the receivers are done
+    }
 
     // ── CONTROL ──────────────────────────────────────────────────────────────
     case BLOCK_Wait: {
-        float secs = (float)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
+        float secs = (float)operand(in, 0, gs, sp);
         ctx.waitTimer = secs;
-        // Do NOT advance PC yet; update() will advance when timer expires
-        Logger::info(logMsg.str() + " -> waiting " + std::to_string(secs) + "s");
+        LOG_DEBUG(Engine, where() + " -> waiting " + std::to_string(secs) + "s");
+        ctx.pc++; // resume after the wait; a zero wait still yields once
         return false; // suspend
     }
     case BLOCK_WaitUntil: {
-        ctx.waitUntilActive = true;
-        // Don't advance; update() polls condition
-        return false;
+        // Re-evaluated every frame until the condition holds
+        if (!evalBool(in.arg[0], gs, sp)) {
+            ctx.waitUntilActive = true;
+            return false;
+        }
+        ctx.waitUntilActive = false;
+        break;
     }
     case BLOCK_Repeat: {
-        int count = (int)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
-        // Execute nested blocks 'count' times inline
-        for (int i = 0; i < count; i++) {
-            SpriteExecCtx innerCtx;
-            while (!innerCtx.finished) {
-                executeOneBlock(gs, sp, innerCtx, block->nested);
-                innerCtx.pc++;
-                if (innerCtx.pc >= (int)block->nested.size()) innerCtx.finished = true;
-                if (!gs.exec.running) goto done;
-            }
-        }
+        ctx.loopCount.push_back((int)operand(in, 0, gs, sp));
+        ctx.loopStart.push_back(ctx.pc + 1);
         break;
     }
-    case BLOCK_RepeatUntil: {
-        while (!evalBool(block->inputs.empty() ? nullptr : block->inputs[0], gs, sp)) {
-            SpriteExecCtx innerCtx;
-            while (!innerCtx.finished) {
-                executeOneBlock(gs, sp, innerCtx, block->nested);
-                innerCtx.pc++;
-                if (innerCtx.pc >= (int)block->nested.size()) innerCtx.finished = true;
-                if (!gs.exec.running) goto done;
-                gs.watchdogCounter++;
-                if (gs.watchdogCounter > GameState::WATCHDOG_LIMIT) {
-                    Logger::warning("Infinite loop detected in RepeatUntil!");
-                    gs.exec.running = false;
-                    goto done;
-                }
+    case OP_LoopNext: {
+        // Top of a repeat: leave the loop once its counter is used up
+        if (ctx.loopCount.empty() || ctx.loopCount.back() <= 0) {
+            if (!ctx.loopCount.empty()) {
+                ctx.loopCount.pop_back();
+                ctx.loopStart.pop_back();
             }
+            ctx.pc = in.target;
+            return true;
         }
+        ctx.loopCount.back()--;
         break;
     }
-    case BLOCK_Forever: {
-        // Infinite loop — watchdog guards it
-        while (gs.exec.running && !gs.exec.paused) {
-            SpriteExecCtx innerCtx;
-            while (!innerCtx.finished) {
-                executeOneBlock(gs, sp, innerCtx, block->nested);
-                innerCtx.pc++;
-                if (innerCtx.pc >= (int)block->nested.size()) innerCtx.finished = true;
-                if (!gs.exec.running) goto done;
-                gs.watchdogCounter++;
-                if (gs.watchdogCounter > GameState::WATCHDOG_LIMIT) {
-                    Logger::warning("Infinite loop detected! Stopping execution");
-                    gs.exec.running = false;
-                    ctx.finished = true;
-                    return false;
-                }
-            }
-        }
-        goto done;
-    }
-    case BLOCK_If: {
-        bool cond = block->inputs.empty() ? false : evalBool(block->inputs[0], gs, sp);
-        if (cond) {
-            SpriteExecCtx innerCtx;
-            while (!innerCtx.finished) {
-                executeOneBlock(gs, sp, innerCtx, block->nested);
-                innerCtx.pc++;
-                if (innerCtx.pc >= (int)block->nested.size()) innerCtx.finished = true;
-            }
+    case BLOCK_RepeatUntil: {
+        if (evalBool(in.arg[0], gs, sp)) {
+            ctx.pc = in.target;
+            return true;
         }
         break;
     }
+    case BLOCK_If:
     case BLOCK_IfElse: {
-        bool cond = block->inputs.empty() ? false : evalBool(block->inputs[0], gs, sp);
-        const auto& branch = cond ? block->nested : block->nested2;
-        SpriteExecCtx innerCtx;
-        while (!innerCtx.finished) {
-            executeOneBlock(gs, sp, innerCtx, branch);
-            innerCtx.pc++;
-            if (innerCtx.pc >= (int)branch.size()) innerCtx.finished = true;
+        // Fall into the then-branch, or jump to the else-branch / end
+        if (!evalBool(in.arg[0], gs, sp)) {
+            ctx.pc = in.target;
+            return true;
         }
         break;
     }
+    case OP_Jump:
+        ctx.pc = in.target;
+        return true;
+    case OP_LoopBack:
+        // End of an iteration: yield, the next one runs on the next pass
+        ctx.pc = in.target;
+        return false;
+    case OP_Halt:
+        ctx.loopCount.clear();
+        ctx.loopStart.clear();
+        ctx.finished = true;
+        return false;
     case BLOCK_Stop: {
         gs.exec.running = false;
+        ctx.loopCount.clear();
+        ctx.loopStart.clear();
         ctx.finished    = true;
-        Logger::info("Stop all");
+        LOG_INFO(Engine, "Stop all");
         return false;
     }
     case BLOCK_AskWait: {
-        gs.askActive   = true;
-        gs.askQuestion = block->stringValue;
-        gs.askInput    = "";
-        gs.askSprite   = sp;
+        shared(gs, sp, [block, sp](GameState& g) {
+            g.askActive   = true;
+            g.askQuestion = block->stringValue;
+            g.askInput    = "";
+            g.askSprite   = sp;
+        });
         ctx.askWaiting = true;
         return false; // suspend until user answers
     }
 
     // ── VARIABLES ────────────────────────────────────────────────────────────
     case BLOCK_SetVariable: {
-        std::string val;
-        if (!block->inputs.empty()) {
-            double d = evalNum(block->inputs[0], gs, sp);
-            std::ostringstream ss; ss << d; val = ss.str();
-        } else {
-            val = block->stringValue.empty()
-                ? std::to_string(block->numberValue)
-                : block->stringValue;
-        }
-        if (gs.variables.find(block->text) != gs.variables.end())
-        {
-            Logger::warning("Variable '" + block->text + "' already exists! Overwriting.");
-        }
-        gs.variables[block->text] = val;
-        Logger::info("Set var [" + block->text + "] = " + val);
+        if (in.var < 0) break;
+        Value v(operand(in, 0, gs, sp));
+        setVar(gs, sp, in.var, v);
+        LOG_DEBUG(Engine, "Set var [" + gs.variables.names[in.var] + "] = " + toString(v));
         break;
     }
     case BLOCK_ChangeVariable: {
-        double cur = 0;
-        auto it = gs.variables.find(block->text);
-        if (it != gs.variables.end()) try { cur = std::stod(it->second); } catch(...) {}
-        double delta = block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp);
-        std::ostringstream ss; ss << (cur + delta);
-        gs.variables[block->text] = ss.str();
+        if (in.var < 0) break;
+        changeVar(gs, sp, in.var, operand(in, 0, gs, sp));
         break;
     }
 
     // ── PEN ──────────────────────────────────────────────────────────────────
     case BLOCK_PenDown:
         sp->penDown = true;
-        Logger::info("PEN DOWN - sprite: " + sp->name + "pendown: " + std::to_string(sp->penDown));
+        LOG_DEBUG(Pen, "PEN DOWN - sprite: " + sp->name + "pendown: " + std::to_string(sp->penDown));
         break;
     case BLOCK_PenUp:
         sp->penDown = false;
-        if (gs.isDrawingStroke && gs.currentStroke.points.size() > 1)
-            gs.penStrokes.push_back(gs.currentStroke);
-        gs.isDrawingStroke = false;
+        shared(gs, sp, [](GameState& g) {
+            if (g.isDrawingStroke && g.currentStroke.points.size() > 1)
+                g.penStrokes.push_back(g.currentStroke);
+            g.isDrawingStroke = false;
+        });
         break;
     case BLOCK_PenClear:
-        gs.penStrokes.clear();
-        gs.isDrawingStroke = false;
+        shared(gs, sp, [](GameState& g) { g.clearPen(); });
         break;
     case BLOCK_SetPenColor: {
         // Cycle preset colours when no input
@@ -597,56 +837,135 @@ bool executeOneBlock(GameState& gs, Sprite* sp, SpriteExecCtx& ctx,
             {255,255,0,255},{255,0,255,255},{0,255,255,255},
             {255,128,0,255},{128,0,255,255}
         };
-        static int ci = 0;
-        sp->penColor = COLORS[(ci++) % 8];
+        static int ci = 0; // shared between sprites
+        shared(gs, sp, [sp](GameState&) { sp->penColor = COLORS[(ci++) % 8]; });
         break;
     }
     case BLOCK_SetPenSize: {
-        int v = (int)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
+        int v = (int)operand(in, 0, gs, sp);
         sp->penSize = std::max(1, std::min(50, v));
         break;
     }
     case BLOCK_ChangePenSize: {
-        int v = (int)(block->inputs.empty() ? block->numberValue : evalNum(block->inputs[0], gs, sp));
+        int v = (int)operand(in, 0, gs, sp);
         sp->penSize = std::max(1, std::min(50, sp->penSize + v));
         break;
     }
     case BLOCK_Stamp: {
         // Stamp current sprite position as a freeze-frame (stored as a special stroke)
-        PenStroke stamp;
-        stamp.color = sp->penColor;
-        stamp.size  = 0; // size=0 signals "stamp" to renderer
         SDL_Point p;
-        p.x = (int)sp->x;
-        p.y = (int)sp->y;
-        stamp.points.push_back(p);
-        stamp.points.push_back(p); // two identical points = stamp marker
-        gs.penStrokes.push_back(stamp);
+        p.x = (int)st.x[id];
+        p.y = (int)st.y[id];
+        shared(gs, sp, [sp, p](GameState& g) {
+            PenStroke stamp;
+            stamp.color = sp->penColor; // as set by this sprite's earlier pen blocks
+            stamp.size  = 0; // size=0 signals "stamp" to renderer
+            stamp.points.push_back(p);
+            stamp.points.push_back(p); // two identical points = stamp marker
+            g.penStrokes.push_back(stamp);
+        });
         break;
     }
 
     // ── SENSING (reporter blocks, no side-effects here) ───────────────────
     case BLOCK_ResetTimer:
-        gs.exec.globalTimer = 0;
+        shared(gs, sp, [](GameState& g) { g.exec.globalTimer = 0; });
         break;
 
     default:
         break;
     }
 
-    done:
-    // Note: goto done is used for early exit (Stop, Forever).
-    // In those cases finished=true or running=false, so pc++ is harmless
-    // but we guard anyway.
-    if (!ctx.finished) {
-        ctx.pc++;
-        gs.watchdogCounter = 0;
-    }
+    if (!ctx.finished) ctx.pc++;
     return !ctx.finished;
 }
 
+// ─── event dispatch ──────────────────────────────────────────────────────────
+
+// Start the thread for script `id`; a hat that is still running restarts
+static void startScript(GameState& state, int id) {
+    const ScriptEntry& se = state.program.scripts[id];
+    int owner = se.sprite->id;
+    if (owner >= (int)state.exec.ctx.size()) state.exec.ctx.resize(state.sprites.size());
+    std::vector<SpriteExecCtx>& threads = state.exec.ctx[owner];
+    SpriteExecCtx t;
+    t.script = id;
+    t.pc     = se.entry;
+    for (auto& th : threads)
+        if (th.script == id) { th = t; return; }
+    threads.push_back(t);
+}
+
+static void startScripts(GameState& state, const std::vector<int>& ids) {
+    for (int id : ids) startScript(state, id);
+}
+
+// Is the window point (mx, my) on the sprite's current costume?
+static bool hitSprite(const GameState& gs, const Sprite* sp, int mx, int my) {
+    const SpriteTable& st = gs.spriteData;
+    int id = sp->id;
+    if (!st.visible[id] || sp->costumes.empty()) return false;
+    const Costume& c = sp->costumes[sp->currentCostume];
+    float hw = c.width  * st.size[id] / 200.0f;
+    float hh = c.height * st.size[id] / 200.0f;
+    float cx = gs.stageX + gs.stageWidth  / 2 + st.x[id];
+    float cy = gs.stageY + gs.stageHeight / 2 - st.y[id];
+    return std::fabs(mx - cx) <= hw && std::fabs(my - cy) <= hh;
+}
+
+// Fire the hats of events that happened since the last tick. Only events
+// somebody listens for are looked at, so the cost follows the listeners,
+// not the size of the project.
+static void dispatchEvents(GameState& state) {
+    const Program& prog = state.program;
+    ExecutionContext& ex = state.exec;
+
+    // Key hats fire on the press edge
+    if (!prog.onKey.empty()) {
+        const Uint8* ks = SDL_GetKeyboardState(nullptr);
+        for (auto& kv : prog.onKey) {
+            SDL_Scancode sc = keyScancode(kv.first);
+            bool down = sc != SDL_SCANCODE_UNKNOWN && ks[sc];
+            bool& was = ex.keyWasDown[kv.first];
+            if (down && !was) {
+                LOG_INFO(Engine, "Key pressed: " + kv.first);
+                startScripts(state, kv.second);
+            }
+            was = down;
+        }
+    }
+
+    // Messages posted during the last tick, in posting order
+    if (!ex.broadcastQueue.empty()) {
+        std::vector<int> posted;
+        posted.swap(ex.broadcastQueue);
+        for (int id : posted)
+            startScripts(state, prog.onMessage[id]);
+    }
+
+    // Click hats: top-most listening sprite under the mouse, on the press edge
+    bool down = state.mousePressed;
+    if (down && !ex.mouseWasDown && !prog.onClick.empty()) {
+        // Same (layer, id) order the stage is drawn in
+        const std::vector<int>& layer = state.spriteData.layer;
+        auto z = [&](const Sprite* s) { return std::make_pair(layer[s->id], s->id); };
+        const Sprite* top = nullptr;
+        for (auto& kv : prog.onClick)
+            if (hitSprite(state, kv.first, state.mouseX, state.mouseY) &&
+                (!top || z(kv.first) > z(top)))
+                top = kv.first;
+        if (top) {
+            LOG_INFO(Engine, "Sprite clicked: " + top->name);
+            startScripts(state, prog.onClick.at(top));
+        }
+    }
+    ex.mouseWasDown = down;
+}
+
 // ─── update (called once per frame) ──────────────────────────────────────────
 void update(GameState& state, float deltaTime) {
+    Timeline::Span tickSpan("engine", "tick");
+
     // 1. Update timers / speech bubbles
     for (auto* sp : state.sprites) {
         if (sp->sayTimer > 0) {
@@ -665,24 +984,6 @@ void update(GameState& state, float deltaTime) {
         startExecution(state);
     }
 
-    // ===== WhenSpriteClicked =====
-    if (state.mousePressed && state.exec.running) {
-        Logger::info("Mouse clicked detected in update!");
-
-        int mx = state.mouseX;
-        int my = state.mouseY;
-
-        for (Block* b : state.editorBlocks) {
-            if (b->type == BLOCK_WhenSpriteClicked) {
-                if (state.selectedSpriteIndex >= 0) {
-                    Sprite* sp = state.sprites[state.selectedSpriteIndex];
-                    state.exec.ctx[sp].finished = false;
-                    Logger::info("WhenSpriteClicked activated by mouse!");
-                }
-            }
-        }
-    }
-
     // 4. Pause / step gate
     if (!state.exec.running) return;
     if (state.exec.paused) {
@@ -694,28 +995,39 @@ void update(GameState& state, float deltaTime) {
         }
     }
 
-    // 5. Execute scripts for each sprite
-    runScripts(state, deltaTime);
+    // 5. Start hats for this tick's events, then run every thread
+    state.exec.tick++;
+    {
+        Timeline::Span span("engine", "dispatch");
+        dispatchEvents(state);
+    }
+    {
+        Timeline::Span span("engine", "scripts");
+        runScripts(state, deltaTime);
+    }
 
     // 6. Pen drawing: append current sprite position to active stroke
+    Timeline::Span penSpan("engine", "pen");
     if (state.selectedSpriteIndex >= 0 &&
         state.selectedSpriteIndex < (int)state.sprites.size())
     {
         Sprite* sp = state.sprites[state.selectedSpriteIndex];
+        float sx = state.spriteData.x[sp->id], sy = state.spriteData.y[sp->id];
         if (sp->penDown && state.exec.running) {
             SDL_Point p;
             int stageOX = state.stageX + state.stageWidth  / 2;
             int stageOY = state.stageY + state.stageHeight / 2;
-            p.x = (int)sp->x;
-            p.y = (int)sp->y; // Y flipped
+            p.x = (int)sx;
+            p.y = (int)sy; // Y flipped
 
             if (!state.isDrawingStroke) {
-                Logger::info("PEN DRAWING - sprite" + sp->name + "at x: " + std::to_string(sp->x) + " y: " + std::to_string(sp->y));
+                LOG_DEBUG(Pen, "PEN DRAWING - sprite" + sp->name + "at x: " + std::to_string(sx) + " y: " + std::to_string(sy));
                 state.currentStroke = PenStroke();
                 state.currentStroke.color = sp->penColor;
                 state.currentStroke.size  = sp->penSize;
                 state.currentStroke.points.push_back(p);
                 state.isDrawingStroke = true;
+                state.penLiveDrawn = 0;
             } else {
                 auto& last = state.currentStroke.points;
                 if (last.empty() || last.back().x != p.x || last.back().y != p.y)
@@ -733,14 +1045,15 @@ void update(GameState& state, float deltaTime) {
         state.selectedSpriteIndex < (int)state.sprites.size())
     {
         Sprite* sp = state.sprites[state.selectedSpriteIndex];
+        float sx = state.spriteData.x[sp->id], sy = state.spriteData.y[sp->id];
         if (sp->penDown && state.exec.running) {
-            Logger::info("PEN - sprite at x:" + std::to_string(sp->x) + " y:" + std::to_string(sp->y));
+            LOG_DEBUG(Pen, "PEN - sprite at x:" + std::to_string(sx) + " y:" + std::to_string(sy));
 
             SDL_Point p;
             int stageOX = state.stageX + state.stageWidth  / 2;
             int stageOY = state.stageY + state.stageHeight / 2;
-            p.x = stageOX + (int)sp->x;
-            p.y = stageOY - (int)sp->y;
+            p.x = stageOX + (int)sx;
+            p.y = stageOY - (int)sy;
 
             if (!state.isDrawingStroke) {
                 state.currentStroke = PenStroke();
@@ -748,137 +1061,219 @@ void update(GameState& state, float deltaTime) {
                 state.currentStroke.size  = sp->penSize;
                 state.currentStroke.points.push_back(p);
                 state.isDrawingStroke = true;
-                Logger::info("PEN - started new stroke at (" + std::to_string(p.x) + "," + std::to_string(p.y) + ")");
+                state.penLiveDrawn = 0;
+                LOG_DEBUG(Pen, "PEN - started new stroke at (" + std::to_string(p.x) + "," + std::to_string(p.y) + ")");
             } else {
                 auto& last = state.currentStroke.points;
                 if (last.empty() || last.back().x != p.x || last.back().y != p.y) {
                     last.push_back(p);
-                    Logger::info("PEN - added point (" + std::to_string(p.x) + "," + std::to_string(p.y) + ")");
+                    LOG_DEBUG(Pen, "PEN - added point (" + std::to_string(p.x) + "," + std::to_string(p.y) + ")");
                 }
             }
         } else if (state.isDrawingStroke && !sp->penDown) {
             if (state.currentStroke.points.size() > 1)
                 state.penStrokes.push_back(state.currentStroke);
             state.isDrawingStroke = false;
-            Logger::info("PEN - stroke finished");
+            LOG_DEBUG(Pen, "PEN - stroke finished");
         }
     }
 }
 
-// ─── start execution (reset PCs) ─────────────────────────────────────────────
+// ─── start execution (reset threads, start green-flag scripts) ──────────────
 void startExecution(GameState& state) {
+    preScan(state);
     state.exec.running = true;
     state.exec.paused  = false;
     state.exec.ctx.clear();
-    state.watchdogCounter = 0;
+    state.exec.ctx.resize(state.sprites.size());
+    state.exec.broadcastQueue.clear();
+    state.exec.keyWasDown.clear();
+    state.exec.mouseWasDown = state.mousePressed;
     state.exec.globalTimer = 0;
+    state.exec.tick        = 0;
+    // Random streams per sprite: draws don't depend on how sprites interleave
+    unsigned seed = (unsigned)rand();
+    for (Sprite* sp : state.sprites) sp->rng = seed ^ (unsigned)sp->id * 0x9E3779B9u;
+    Profiler::reset((int)state.program.scripts.size());
 
+    startScripts(state, state.program.onFlag);
+    LOG_INFO(Engine, "Execution started — " + std::to_string(state.sprites.size()) + " sprite(s), " +
+                 std::to_string(state.program.onFlag.size()) + " green-flag script(s)");
+}
 
-    const Uint8* ks = SDL_GetKeyboardState(nullptr);
-    for (auto* sp : state.sprites) {
-        for (Block* b : sp->scripts) {
-            if (b->type == BLOCK_WhenKeyPressed) {
-                std::string key = b->stringValue;
-                bool pressed = false;
-                if (key == "space") pressed = ks[SDL_SCANCODE_SPACE];
-                else if (key == "up") pressed = ks[SDL_SCANCODE_UP];
-                else if (key == "down") pressed = ks[SDL_SCANCODE_DOWN];
-                else if (key == "left") pressed = ks[SDL_SCANCODE_LEFT];
-                else if (key == "right") pressed = ks[SDL_SCANCODE_RIGHT];
-
-                if (pressed) {
-                    state.exec.ctx[sp] = SpriteExecCtx();
-                    state.exec.ctx[sp].finished = false;
-                    Logger::info("Key pressed: " + key);
-                }
+// ─── run scripts (passes over all threads until the frame budget is spent) ───
+
+static WorkerPool& workerPool() {
+    static WorkerPool pool; // started on first parallel tick
+    return pool;
+}
+
+// Share of the frame scripts may use outside turbo mode; the rest is left
+// for input, rendering and the frame delay
+static const double SCRIPT_BUDGET = 0.75;
+
+// Blocks whose effect shows on the stage. Outside turbo mode a pass that ran
+// one ends the frame, so animation loops advance one iteration per frame.
+static bool isVisual(BlockType t) {
+    if (t >= BLOCK_Move && t <= BLOCK_GoBackwardLayers) return true; // motion, looks
+    switch (t) {
+        case BLOCK_ShowVariable: case BLOCK_HideVariable:
+        case BLOCK_PenClear:     case BLOCK_Stamp:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Serial once-per-tick pass: wait timers, plus waits that depend on other
+// sprites (ask dialog, broadcast receivers), so stepping a sprite only ever
+// touches its own threads
+static void wakeThreads(GameState& state, float deltaTime) {
+    for (int id = 0; id < (int)state.exec.ctx.size(); id++) {
+        Sprite* sp = state.sprites[id];
+        for (SpriteExecCtx& ctx : state.exec.ctx[id]) {
+            if (ctx.finished) continue;
+
+            // Wait timer (BLOCK_Wait already moved past the block)
+            if (ctx.waitTimer > 0) ctx.waitTimer -= deltaTime;
+
+            // Answer received from ask dialog
+            if (ctx.askWaiting && !state.askActive) {
+                sp->answer     = state.askInput;
+                ctx.askWaiting = false;
+                ctx.pc++;
+            }
+
+            // Broadcast-and-wait: resume once every receiver has finished
+            if (ctx.waitMessage >= 0 && !receiversRunning(state, ctx.waitMessage)) {
+                ctx.waitMessage = -1;
+                ctx.pc++; // advance past the broadcast
             }
         }
     }
+}
 
-    if (!state.exec.pendingBroadcast.empty()) {
-        Logger::info("Processing broadcast: " + state.exec.pendingBroadcast);
+// What one pass over a sprite's threads did
+enum { STEP_PROGRESS = 1, STEP_REDRAW = 2 };
 
-        for (Block* b : state.editorBlocks) {
-            if (b->type == BLOCK_WhenReceive && b->stringValue == state.exec.pendingBroadcast) {
-                if (state.selectedSpriteIndex >= 0) {
-                    Sprite* sp = state.sprites[state.selectedSpriteIndex];
-                    state.exec.ctx[sp] = SpriteExecCtx();
-                    state.exec.ctx[sp].finished = false;
-                    Logger::info("Receive block activated for: " + b->stringValue);
-                }
-            }
+// Run every thread of one sprite up to its next yield
+static int stepSprite(GameState& state, int id) {
+    Sprite* sp = state.sprites[id];
+    const Program& prog = state.program;
+    Timeline::Span slice("script", sp->name);
+    int result = 0;
+    for (SpriteExecCtx& ctx : state.exec.ctx[id]) {
+        if (!state.exec.running) break; // stop all
+
+        if (ctx.finished || ctx.askWaiting || ctx.waitMessage >= 0 ||
+            ctx.waitTimer > 0) continue;
+
+        // Execute blocks until suspension or end
+        ctx.watchdog = 0;
+        for (;;) {
+            int pc = ctx.pc;
+            if (pc >= 0 && pc < (int)prog.code.size() && isVisual(prog.code[pc].op))
+                result |= STEP_REDRAW;
+            bool cont = executeOneBlock(state, sp, ctx, prog);
+            if (ctx.pc != pc || ctx.finished) result |= STEP_PROGRESS; // a failed wait-until is not
+            if (!cont) break;
         }
-        state.exec.pendingBroadcast = "";  // پاکش کن
     }
-    if (state.mousePressed)
-    {
-        for (Block* b : state.editorBlocks)
-        {
-            if (b->type == BLOCK_WhenSpriteClicked)
-            {
-                if (state.selectedSpriteIndex >= 0)
-                {
-                    Sprite* sp = state.sprites[state.selectedSpriteIndex];
-                    state.exec.ctx[sp] = SpriteExecCtx();
-                    state.exec.ctx[sp].finished = false;
-                    Logger::info("Sprite clicked!");
-                }
-            }
+    return result;
+}
+
+// Replay the shared writes of sprites [first, end) in sprite order, exactly
+// as serial steps would have applied them
+static void commitShared(GameState& state, int first, int end) {
+    state.exec.deferShared = false;
+    for (int id = first; id < end; id++) {
+        DeferredWrites& w = state.exec.writes[id];
+        for (const VarWrite& v : w.varLog) {
+            Value& dst = state.variables.values[v.slot];
+            if (v.delta) addTo(dst, v.value.doubleVal);
+            else         dst = v.value;
         }
+        for (auto& op : w.ops) op(state);
+        w.clear();
     }
+}
 
-    for (auto* sp : state.sprites) {
-        SpriteExecCtx ctx;
-        state.exec.ctx[sp] = ctx;
+// One slice for every thread; returns the STEP_* flags of all sprites
+static int runPass(GameState& state) {
+    int count = (int)state.exec.ctx.size();
+    int result = 0;
+    if (!state.exec.parallel || count < 2) {
+        for (int id = 0; id < count && state.exec.running; id++)
+            result |= stepSprite(state, id);
+        return result;
     }
-    Logger::info("Execution started — " + std::to_string(state.sprites.size()) + " sprite(s)");
+
+    // Parallel: each run of sprites that don't depend on one another steps on
+    // the pool and is committed before the next ordered sprite steps alone
+    const std::vector<char>& ordered = state.program.ordered;
+    auto alone = [&](int id) { return id >= (int)ordered.size() || ordered[id]; };
+    std::vector<int> flags(count, 0);
+    state.exec.writes.resize(count);
+    for (DeferredWrites& w : state.exec.writes) w.resize(state.variables.size());
+    for (int first = 0; first < count && state.exec.running; ) {
+        int end = first + 1;
+        if (!alone(first))
+            while (end < count && !alone(end)) end++;
+        if (end - first == 1) {
+            result |= stepSprite(state, first);
+        } else {
+            state.exec.deferShared = true;
+            workerPool().run(end - first, [&, first](int i) { flags[first + i] = stepSprite(state, first + i); });
+            commitShared(state, first, end);
+            for (int id = first; id < end; id++) result |= flags[id];
+        }
+        first = end;
+    }
+    return result;
 }
 
-// ─── run scripts (one step per sprite per frame) ─────────────────────────────
 void runScripts(GameState& state, float deltaTime) {
-    if (state.editorBlocks.empty()) {
+    if (state.program.code.empty()) {
         state.exec.running = false;
         return;
     }
 
-    for (auto* sp : state.sprites) {
-        if (state.exec.ctx.find(sp) == state.exec.ctx.end()) continue;
-        SpriteExecCtx& ctx = state.exec.ctx[sp];
-
-        if (ctx.finished || ctx.askWaiting) continue;
+    wakeThreads(state, deltaTime);
 
-        // Waiting for timer (BLOCK_Wait)
-        if (ctx.waitTimer > 0) {
-            ctx.waitTimer -= deltaTime;
-            if (ctx.waitTimer > 0) continue;
-            ctx.waitTimer = 0;
-            ctx.pc++; // advance past the wait block
-        }
-
-        // Answer received from ask dialog
-        if (ctx.askWaiting && !state.askActive) {
-            sp->answer     = state.askInput;
-            ctx.askWaiting = false;
-            ctx.pc++;
-        }
-
-        // Execute blocks until suspension or end
-        int maxPerFrame = 200;
-        while (!ctx.finished && ctx.waitTimer <= 0 && !ctx.askWaiting && maxPerFrame-- > 0) {
-            if (ctx.pc >= (int)state.editorBlocks.size()) {
-                ctx.finished = true;
-                break;
-            }
-            bool cont = executeOneBlock(state, sp, ctx, state.editorBlocks);
-            if (!cont) break;
+    // Keep giving threads passes until the budget is used, nothing moved, or
+    // (outside turbo) something visible changed. Step mode gets one pass.
+    // With a pass limit the budget is a pass count, not time.
+    const Uint64 freq   = SDL_GetPerformanceFrequency();
+    const Uint64 start  = SDL_GetPerformanceCounter();
+    const double share  = state.exec.turbo ? 1.0 : SCRIPT_BUDGET;
+    const Uint64 budget = (Uint64)(state.exec.frameTime * share * freq);
+    const int    limit  = state.exec.passLimit;
+    for (int passes = 1; ; passes++) {
+        int result;
+        {
+            Timeline::Span span("engine", "pass");
+            result = runPass(state);
         }
+        if (!state.exec.running || state.exec.paused) break;
+        if (!(result & STEP_PROGRESS)) break;
+        if ((result & STEP_REDRAW) && !state.exec.turbo) break;
+        if (limit > 0 ? passes >= limit : SDL_GetPerformanceCounter() - start >= budget) break;
     }
 
-    // Check if all scripts finished
+    // Drop finished threads
     bool anyRunning = false;
-    for (auto& kv : state.exec.ctx)
-        if (!kv.second.finished) anyRunning = true;
-    if (!anyRunning) state.exec.running = false;
+    for (auto& threads : state.exec.ctx) {
+        threads.erase(std::remove_if(threads.begin(), threads.end(),
+                                     [](const SpriteExecCtx& t) { return t.finished; }),
+                      threads.end());
+        if (!threads.empty()) anyRunning = true;
+    }
+
+    // Keep running while a thread is alive or a key / click hat can still fire
+    const Program& prog = state.program;
+    bool canWake = !prog.onKey.empty() || !prog.onClick.empty() ||
+                   !state.exec.broadcastQueue.empty();
+    if (!anyRunning && !canWake) state.exec.running = false;
 }
 
 } // namespace Engine
@@ -2,10 +2,15 @@
 #include "GameState.h"
 
 namespace Engine {
+    const int TICK_RATE = 30; // simulation ticks per second, as in Scratch
+    // Headless runs: passes per tick in place of the wall-clock budget, so
+    // the work done per tick is the same on every machine
+    const int HEADLESS_PASSES = 1000;
+
     void update(GameState& state, float deltaTime);
     void startExecution(GameState& state);
     void runScripts(GameState& state, float deltaTime);
     bool executeOneBlock(GameState& gs, Sprite* sp, SpriteExecCtx& ctx,
-                         const std::vector<Block*>& script);
+                         const Program& prog);
     void preScan(GameState& gs);
 }
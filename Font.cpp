@@ -0,0 +1,298 @@
+#include "Font.h"
+#include "Logger.h"
+#include "MemStats.h"
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace Font {
+    // 5x7 glyphs, printable ASCII 32-126
+    static const unsigned char FONT5x7[95][7] = {
+        {0x00,0x00,0x00,0x00,0x00,0x00,0x00}, // space
+        {0x04,0x04,0x04,0x04,0x00,0x04,0x00}, // !
+        {0x0A,0x0A,0x00,0x00,0x00,0x00,0x00}, // "
+        {0x0A,0x1F,0x0A,0x0A,0x1F,0x0A,0x00}, // #
+        {0x04,0x0F,0x14,0x0E,0x05,0x1E,0x04}, // $
+        {0x18,0x19,0x02,0x04,0x08,0x13,0x03}, // %
+        {0x0C,0x12,0x14,0x08,0x15,0x12,0x0D}, // &
+        {0x04,0x04,0x00,0x00,0x00,0x00,0x00}, // '
+        {0x02,0x04,0x08,0x08,0x08,0x04,0x02}, // (
+        {0x08,0x04,0x02,0x02,0x02,0x04,0x08}, // )
+        {0x00,0x04,0x15,0x0E,0x15,0x04,0x00}, // *
+        {0x00,0x04,0x04,0x1F,0x04,0x04,0x00}, // +
+        {0x00,0x00,0x00,0x00,0x04,0x04,0x08}, // ,
+        {0x00,0x00,0x00,0x1F,0x00,0x00,0x00}, // -
+        {0x00,0x00,0x00,0x00,0x00,0x04,0x00}, // .
+        {0x01,0x01,0x02,0x04,0x08,0x10,0x10}, // /
+        {0x0E,0x11,0x13,0x15,0x19,0x11,0x0E}, // 0
+        {0x04,0x0C,0x04,0x04,0x04,0x04,0x0E}, // 1
+        {0x0E,0x11,0x01,0x06,0x08,0x10,0x1F}, // 2
+        {0x1F,0x01,0x02,0x06,0x01,0x11,0x0E}, // 3
+        {0x02,0x06,0x0A,0x12,0x1F,0x02,0x02}, // 4
+        {0x1F,0x10,0x1E,0x01,0x01,0x11,0x0E}, // 5
+        {0x06,0x08,0x10,0x1E,0x11,0x11,0x0E}, // 6
+        {0x1F,0x01,0x02,0x04,0x08,0x08,0x08}, // 7
+        {0x0E,0x11,0x11,0x0E,0x11,0x11,0x0E}, // 8
+        {0x0E,0x11,0x11,0x0F,0x01,0x02,0x0C}, // 9
+        {0x00,0x04,0x00,0x00,0x04,0x00,0x00}, // :
+        {0x00,0x04,0x00,0x00,0x04,0x04,0x08}, // ;
+        {0x02,0x04,0x08,0x10,0x08,0x04,0x02}, // <
+        {0x00,0x00,0x1F,0x00,0x1F,0x00,0x00}, // =
+        {0x08,0x04,0x02,0x01,0x02,0x04,0x08}, // >
+        {0x0E,0x11,0x01,0x02,0x04,0x00,0x04}, // ?
+        {0x0E,0x11,0x17,0x15,0x17,0x10,0x0E}, // @
+        {0x0E,0x11,0x11,0x1F,0x11,0x11,0x11}, // A
+        {0x1E,0x11,0x11,0x1E,0x11,0x11,0x1E}, // B
+        {0x0E,0x11,0x10,0x10,0x10,0x11,0x0E}, // C
+        {0x1C,0x12,0x11,0x11,0x11,0x12,0x1C}, // D
+        {0x1F,0x10,0x10,0x1E,0x10,0x10,0x1F}, // E
+        {0x1F,0x10,0x10,0x1E,0x10,0x10,0x10}, // F
+        {0x0E,0x11,0x10,0x17,0x11,0x11,0x0F}, // G
+        {0x11,0x11,0x11,0x1F,0x11,0x11,0x11}, // H
+        {0x0E,0x04,0x04,0x04,0x04,0x04,0x0E}, // I
+        {0x07,0x02,0x02,0x02,0x02,0x12,0x0C}, // J
+        {0x11,0x12,0x14,0x18,0x14,0x12,0x11}, // K
+        {0x10,0x10,0x10,0x10,0x10,0x10,0x1F}, // L
+        {0x11,0x1B,0x15,0x15,0x11,0x11,0x11}, // M
+        {0x11,0x19,0x15,0x13,0x11,0x11,0x11}, // N
+        {0x0E,0x11,0x11,0x11,0x11,0x11,0x0E}, // O
+        {0x1E,0x11,0x11,0x1E,0x10,0x10,0x10}, // P
+        {0x0E,0x11,0x11,0x11,0x15,0x12,0x0D}, // Q
+        {0x1E,0x11,0x11,0x1E,0x14,0x12,0x11}, // R
+        {0x0F,0x10,0x10,0x0E,0x01,0x01,0x1E}, // S
+        {0x1F,0x04,0x04,0x04,0x04,0x04,0x04}, // T
+        {0x11,0x11,0x11,0x11,0x11,0x11,0x0E}, // U
+        {0x11,0x11,0x11,0x11,0x11,0x0A,0x04}, // V
+        {0x11,0x11,0x15,0x15,0x15,0x15,0x0A}, // W
+        {0x11,0x11,0x0A,0x04,0x0A,0x11,0x11}, // X
+        {0x11,0x11,0x0A,0x04,0x04,0x04,0x04}, // Y
+        {0x1F,0x01,0x02,0x04,0x08,0x10,0x1F}, // Z
+        {0x0E,0x08,0x08,0x08,0x08,0x08,0x0E}, // [
+        {0x10,0x10,0x08,0x04,0x02,0x01,0x01}, // backslash
+        {0x0E,0x02,0x02,0x02,0x02,0x02,0x0E}, // ]
+        {0x04,0x0A,0x11,0x00,0x00,0x00,0x00}, // ^
+        {0x00,0x00,0x00,0x00,0x00,0x00,0x1F}, // _
+        {0x08,0x04,0x00,0x00,0x00,0x00,0x00}, // `
+        {0x00,0x00,0x0E,0x01,0x0F,0x11,0x0F}, // a
+        {0x10,0x10,0x1E,0x11,0x11,0x11,0x1E}, // b
+        {0x00,0x00,0x0E,0x10,0x10,0x10,0x0E}, // c
+        {0x01,0x01,0x0F,0x11,0x11,0x11,0x0F}, // d
+        {0x00,0x00,0x0E,0x11,0x1F,0x10,0x0E}, // e
+        {0x06,0x09,0x08,0x1C,0x08,0x08,0x08}, // f
+        {0x00,0x00,0x0F,0x11,0x0F,0x01,0x0E}, // g
+        {0x10,0x10,0x16,0x19,0x11,0x11,0x11}, // h
+        {0x04,0x00,0x0C,0x04,0x04,0x04,0x0E}, // i
+        {0x02,0x00,0x06,0x02,0x02,0x12,0x0C}, // j
+        {0x10,0x10,0x12,0x14,0x18,0x14,0x12}, // k
+        {0x0C,0x04,0x04,0x04,0x04,0x04,0x0E}, // l
+        {0x00,0x00,0x1A,0x15,0x15,0x11,0x11}, // m
+        {0x00,0x00,0x16,0x19,0x11,0x11,0x11}, // n
+        {0x00,0x00,0x0E,0x11,0x11,0x11,0x0E}, // o
+        {0x00,0x00,0x1E,0x11,0x1E,0x10,0x10}, // p
+        {0x00,0x00,0x0F,0x11,0x0F,0x01,0x01}, // q
+        {0x00,0x00,0x16,0x19,0x10,0x10,0x10}, // r
+        {0x00,0x00,0x0E,0x10,0x0E,0x01,0x1E}, // s
+        {0x08,0x08,0x1C,0x08,0x08,0x09,0x06}, // t
+        {0x00,0x00,0x11,0x11,0x11,0x13,0x0D}, // u
+        {0x00,0x00,0x11,0x11,0x11,0x0A,0x04}, // v
+        {0x00,0x00,0x11,0x15,0x15,0x15,0x0A}, // w
+        {0x00,0x00,0x11,0x0A,0x04,0x0A,0x11}, // x
+        {0x00,0x00,0x11,0x11,0x0F,0x01,0x0E}, // y
+        {0x00,0x00,0x1F,0x02,0x04,0x08,0x1F}, // z
+        {0x06,0x08,0x08,0x18,0x08,0x08,0x06}, // {
+        {0x04,0x04,0x04,0x00,0x04,0x04,0x04}, // |
+        {0x0C,0x02,0x02,0x03,0x02,0x02,0x0C}, // }
+        {0x08,0x15,0x02,0x00,0x00,0x00,0x00}, // ~
+    };
+
+    // Atlas: for each scale s, a band of 16x6 cells of (ADVANCE*s x 8*s)
+    static const int COLS = 16, ROWS = 6;
+    static const int ATLAS_W = COLS * ADVANCE * MAX_SCALE;
+    static const int ATLAS_H = ROWS * 8 * (MAX_SCALE * (MAX_SCALE + 1) / 2);
+
+    static SDL_Texture*  atlas = nullptr;
+    static SDL_Renderer* owner = nullptr;
+    static int           bandY[MAX_SCALE + 1];
+
+    // Scratch reused across calls; text is only drawn from the main thread
+    static std::vector<SDL_Vertex> verts;
+    static std::vector<int>        indices;
+    static std::vector<SDL_Rect>   pixels;
+
+    // Label cache: most recently drawn at the front of `lru`
+    struct Label {
+        std::string  key;
+        SDL_Texture* texture;
+        int          w, h;
+        long long    bytes;
+    };
+    static std::list<Label> lru;
+    static std::unordered_map<std::string, std::list<Label>::iterator> labels;
+    static long long labelBytes = 0;
+
+    static void dropLabel(std::list<Label>::iterator it) {
+        SDL_DestroyTexture(it->texture);
+        MemStats::remove(MemStats::MEM_Textures, it->bytes);
+        labelBytes -= it->bytes;
+        labels.erase(it->key);
+        lru.erase(it);
+    }
+
+    static void bake(SDL_Renderer* r) {
+        shutdown();
+        owner = r;
+
+        std::vector<Uint32> img(ATLAS_W * ATLAS_H, 0);
+        int y0 = 0;
+        for (int s = 1; s <= MAX_SCALE; s++) {
+            bandY[s] = y0;
+            for (int g = 0; g < 95; g++) {
+                int cx = (g % COLS) * ADVANCE * s, cy = y0 + (g / COLS) * 8 * s;
+                for (int row = 0; row < GLYPH_H * s; row++) {
+                    unsigned char bits = FONT5x7[g][row / s];
+                    for (int col = 0; col < GLYPH_W * s; col++)
+                        if (bits & (0x10 >> (col / s)))
+                            img[(cy + row) * ATLAS_W + cx + col] = 0xFFFFFFFF;
+                }
+            }
+            y0 += ROWS * 8 * s;
+        }
+
+        atlas = SDL_CreateTexture(r, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, ATLAS_W, ATLAS_H);
+        if (!atlas) {
+            LOG_WARN(Renderer, std::string("Font atlas unavailable, drawing text per pixel: ") + SDL_GetError());
+            return;
+        }
+        SDL_UpdateTexture(atlas, nullptr, img.data(), ATLAS_W * 4);
+        SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+        MemStats::add(MemStats::MEM_Textures, (long long)ATLAS_W * ATLAS_H * 4);
+    }
+
+    void shutdown() {
+        while (!lru.empty()) dropLabel(lru.begin());
+        if (atlas) {
+            SDL_DestroyTexture(atlas);
+            MemStats::remove(MemStats::MEM_Textures, (long long)ATLAS_W * ATLAS_H * 4);
+        }
+        atlas = nullptr;
+        owner = nullptr;
+    }
+
+    int textWidth(const std::string& text, int scale) {
+        int w = 0;
+        for (char c : text) w += (c == ' ' ? SPACE_ADVANCE : ADVANCE) * scale;
+        return w;
+    }
+
+    // Whether any character of the text draws pixels (spaces and unknown
+    // characters only advance)
+    static bool hasGlyph(const std::string& text) {
+        for (char c : text) {
+            int g = (unsigned char)c - 32;
+            if (c != ' ' && g >= 0 && g < 95) return true;
+        }
+        return false;
+    }
+
+    // Fallback when the atlas could not be created: still one call per string
+    static void drawPixels(SDL_Renderer* r, const std::string& text, int x, int y, SDL_Color col, int s) {
+        pixels.clear();
+        int cx = x;
+        for (char c : text) {
+            int g = (unsigned char)c - 32;
+            if (c != ' ' && g >= 0 && g < 95)
+                for (int row = 0; row < GLYPH_H; row++)
+                    for (int c2 = 0; c2 < GLYPH_W; c2++)
+                        if (FONT5x7[g][row] & (0x10 >> c2))
+                            pixels.push_back({cx + c2 * s, y + row * s, s, s});
+            cx += (c == ' ' ? SPACE_ADVANCE : ADVANCE) * s;
+        }
+        if (pixels.empty()) return;
+        SDL_SetRenderDrawColor(r, col.r, col.g, col.b, col.a);
+        SDL_RenderFillRects(r, pixels.data(), (int)pixels.size());
+    }
+
+    void drawText(SDL_Renderer* r, const std::string& text, int x, int y, SDL_Color col, int scale) {
+        if (text.empty() || scale < 1) return;
+        if (r != owner) bake(r);
+        if (!atlas) { drawPixels(r, text, x, y, col, scale); return; }
+
+        int baked = scale <= MAX_SCALE ? scale : 1;
+        verts.clear();
+        indices.clear();
+        int cx = x;
+        for (char c : text) {
+            int g = (unsigned char)c - 32;
+            if (c != ' ' && g >= 0 && g < 95) {
+                float u0 = (float)((g % COLS) * ADVANCE * baked) / ATLAS_W;
+                float v0 = (float)(bandY[baked] + (g / COLS) * 8 * baked) / ATLAS_H;
+                float u1 = u0 + (float)(GLYPH_W * baked) / ATLAS_W;
+                float v1 = v0 + (float)(GLYPH_H * baked) / ATLAS_H;
+                float x0 = (float)cx, y0 = (float)y;
+                float x1 = x0 + GLYPH_W * scale, y1 = y0 + GLYPH_H * scale;
+
+                int base = (int)verts.size();
+                verts.push_back({{x0, y0}, col, {u0, v0}});
+                verts.push_back({{x1, y0}, col, {u1, v0}});
+                verts.push_back({{x1, y1}, col, {u1, v1}});
+                verts.push_back({{x0, y1}, col, {u0, v1}});
+                for (int i : {0, 1, 2, 0, 2, 3}) indices.push_back(base + i);
+            }
+            cx += (c == ' ' ? SPACE_ADVANCE : ADVANCE) * scale;
+        }
+        if (verts.empty()) return;
+        SDL_RenderGeometry(r, atlas, verts.data(), (int)verts.size(), indices.data(), (int)indices.size());
+    }
+
+    // Rasterizes straight into pixels, so labels need no render target
+    static SDL_Texture* rasterize(SDL_Renderer* r, const std::string& text, SDL_Color col, int s, int w, int h) {
+        std::vector<Uint32> img(w * h, 0);
+        Uint32 argb = (Uint32)col.a << 24 | (Uint32)col.r << 16 | (Uint32)col.g << 8 | col.b;
+        int cx = 0;
+        for (char c : text) {
+            int g = (unsigned char)c - 32;
+            if (c != ' ' && g >= 0 && g < 95)
+                for (int row = 0; row < GLYPH_H * s; row++)
+                    for (int c2 = 0; c2 < GLYPH_W * s; c2++)
+                        if (FONT5x7[g][row / s] & (0x10 >> (c2 / s)))
+                            img[row * w + cx + c2] = argb;
+            cx += (c == ' ' ? SPACE_ADVANCE : ADVANCE) * s;
+        }
+        SDL_Texture* tex = SDL_CreateTexture(r, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, w, h);
+        if (!tex) return nullptr;
+        SDL_UpdateTexture(tex, nullptr, img.data(), w * 4);
+        SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+        return tex;
+    }
+
+    void drawLabel(SDL_Renderer* r, const std::string& text, int x, int y, SDL_Color col, int scale) {
+        if (scale < 1 || !hasGlyph(text)) return; // blank runs need no texture
+        if (r != owner) bake(r);
+
+        std::string key = text;
+        key.push_back('\0');
+        key.append({(char)col.r, (char)col.g, (char)col.b, (char)col.a, (char)scale});
+
+        auto found = labels.find(key);
+        if (found != labels.end()) {
+            lru.splice(lru.begin(), lru, found->second);
+        } else {
+            // Width less the trailing gap
+            int w = textWidth(text, scale) - scale, h = GLYPH_H * scale;
+            SDL_Texture* tex = rasterize(r, text, col, scale, w, h);
+            if (!tex) { drawText(r, text, x, y, col, scale); return; }
+
+            long long bytes = (long long)w * h * 4;
+            lru.push_front({key, tex, w, h, bytes});
+            labels[key] = lru.begin();
+            labelBytes += bytes;
+            MemStats::add(MemStats::MEM_Textures, bytes);
+            while (labelBytes > LABEL_CACHE_BYTES && lru.size() > 1)
+                dropLabel(std::prev(lru.end()));
+        }
+
+        const Label& l = lru.front();
+        SDL_Rect dst = {x, y, l.w, l.h};
+        SDL_RenderCopy(r, l.texture, nullptr, &dst);
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <string>
+
+// Built-in 5x7 pixel font shared by Renderer and UIManager (no SDL_ttf).
+// Glyphs are baked once per renderer into a texture atlas, one band per
+// scale up to MAX_SCALE, and each string is drawn as a single textured
+// quad batch tinted by vertex colour.
+namespace Font {
+    const int GLYPH_W = 5, GLYPH_H = 7;
+    const int ADVANCE = 6, SPACE_ADVANCE = 4; // at scale 1
+    const int MAX_SCALE = 3;                  // larger scales stretch the 1x glyphs
+
+    void drawText(SDL_Renderer* r, const std::string& text, int x, int y,
+                  SDL_Color col = {255, 255, 255, 255}, int scale = 1);
+    int  textWidth(const std::string& text, int scale = 1);
+
+    // Static labels: each (text, colour, scale) run is rasterized once into
+    // its own texture and blitted afterwards. Least recently drawn runs are
+    // evicted once the cache exceeds LABEL_CACHE_BYTES.
+    const long long LABEL_CACHE_BYTES = 4 << 20;
+    void drawLabel(SDL_Renderer* r, const std::string& text, int x, int y,
+                   SDL_Color col = {255, 255, 255, 255}, int scale = 1);
+
+    void shutdown(); // before the renderer is destroyed; drops atlas and labels
+}
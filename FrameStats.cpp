@@ -0,0 +1,81 @@
+#include "FrameStats.h"
+#include "Logger.h"
+#include "Timeline.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace FrameStats {
+    bool  showOverlay = false;
+    float logInterval = 0;
+
+    static Uint64 frameStart = 0, lastLog = 0;
+    static Uint64 started[PH_Count];
+    static Uint64 spent[PH_Count];        // this frame, counter ticks
+    static float  samples[PH_Count][WINDOW]; // ms, ring per phase
+    static int    next = 0, filled = 0;
+
+    static double toMs(Uint64 ticks) {
+        return ticks * 1000.0 / SDL_GetPerformanceFrequency();
+    }
+
+    const char* phaseName(Phase phase) {
+        static const char* names[PH_Count] = {
+            "events", "update", "ui", "palette", "editor",
+            "stage", "monitor", "present", "frame"
+        };
+        return names[phase];
+    }
+
+    void beginFrame() {
+        frameStart = SDL_GetPerformanceCounter();
+        if (!lastLog) lastLog = frameStart;
+        std::fill(spent, spent + PH_Count, 0);
+    }
+
+    void begin(Phase phase) { started[phase] = SDL_GetPerformanceCounter(); }
+    void end(Phase phase) {
+        Uint64 now = SDL_GetPerformanceCounter();
+        spent[phase] += now - started[phase];
+        if (Timeline::recording) Timeline::record("frame", phaseName(phase), started[phase], now);
+    }
+
+    Percentiles percentiles(Phase phase) {
+        Percentiles p = {0, 0, 0};
+        if (filled == 0) return p;
+        std::vector<float> v(samples[phase], samples[phase] + filled);
+        auto at = [&](double q) {
+            auto nth = v.begin() + (size_t)(q * (v.size() - 1));
+            std::nth_element(v.begin(), nth, v.end());
+            return (double)*nth;
+        };
+        p.p50 = at(0.50);
+        p.p95 = at(0.95);
+        p.p99 = at(0.99);
+        return p;
+    }
+
+    void endFrame() {
+        Uint64 now = SDL_GetPerformanceCounter();
+        spent[PH_Frame] = now - frameStart;
+        Timeline::frameDone(frameStart, now);
+        for (int p = 0; p < PH_Count; p++)
+            samples[p][next] = (float)toMs(spent[p]);
+        next = (next + 1) % WINDOW;
+        if (filled < WINDOW) filled++;
+
+        if (logInterval > 0 && toMs(now - lastLog) >= logInterval * 1000.0) {
+            lastLog = now;
+            Logger::info("Frame phases over last " + std::to_string(filled) +
+                         " frames (ms p50/p95/p99):");
+            for (int p = 0; p < PH_Count; p++) {
+                Percentiles q = percentiles((Phase)p);
+                char buf[80];
+                snprintf(buf, sizeof buf, "  %-8s %6.2f %6.2f %6.2f",
+                         phaseName((Phase)p), q.p50, q.p95, q.p99);
+                Logger::info(buf);
+            }
+        }
+    }
+}
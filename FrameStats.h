@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+
+// Frame phase timing. gameLoop brackets each phase with begin()/end() on
+// the performance counter; endFrame() stores the frame's per-phase totals
+// in a rolling window, from which p50/p95/p99 are taken on demand.
+namespace FrameStats {
+    enum Phase {
+        PH_Events, PH_Update, PH_UI, PH_Palette, PH_Editor,
+        PH_Stage, PH_Monitor, PH_Present, PH_Frame, PH_Count
+    };
+    const int WINDOW = 512; // frames kept per phase
+
+    struct Percentiles { double p50, p95, p99; }; // milliseconds
+
+    void beginFrame();
+    void begin(Phase phase);
+    void end(Phase phase);   // a phase may run several times per frame; times add up
+    void endFrame();         // also logs a summary every logInterval seconds
+
+    Percentiles percentiles(Phase phase);
+    const char* phaseName(Phase phase);
+
+    extern bool  showOverlay; // F5: on-screen table (Renderer::renderFrameStats)
+    extern float logInterval; // F6: seconds between log summaries, 0 = off
+}
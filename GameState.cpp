@@ -1,4 +1,8 @@
 #include "GameState.h"
+#include "MemStats.h"
+#include <algorithm>
+#include <iterator>
+#include <sstream>
 
 // ─────────────────────────────────────────────────────────────────────────────
 Block::Block() {
@@ -7,30 +11,215 @@ Block::Block() {
     x = y = 0; width = 185; height = 36;
     nextBlock = nullptr; selected = false; isDragging = false;
     jumpTarget = -1; elseTarget = -1;
+    varSlot = -1;
+    pure = false; constant = false;
+    constNum = 0; constBool = false;
 }
 Block::~Block() {
     // Do NOT recursively delete children here — ownership is in vectors
 }
+void* Block::operator new(size_t size) {
+    MemStats::add(MemStats::MEM_Blocks, (long long)size);
+    return ::operator new(size);
+}
+void Block::operator delete(void* p, size_t size) {
+    MemStats::remove(MemStats::MEM_Blocks, (long long)size);
+    ::operator delete(p);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+Instr::Instr() : op(BLOCK_None), target(-1), src(nullptr), var(-1), msg(-1) {
+    num[0] = num[1] = 0;
+    arg[0] = arg[1] = nullptr;
+}
+
+double toDouble(const Value& v) {
+    switch (v.type) {
+        case Value::DOUBLE: return v.doubleVal;
+        case Value::BOOL:   return v.boolVal ? 1.0 : 0.0;
+        case Value::STRING:
+            try { return std::stod(v.stringVal); }
+            catch (...) { return 0.0; }
+    }
+    return 0.0;
+}
+
+std::string toString(const Value& v) {
+    switch (v.type) {
+        case Value::STRING: return v.stringVal;
+        case Value::BOOL:   return v.boolVal ? "true" : "false";
+        case Value::DOUBLE: {
+            std::ostringstream ss; ss << v.doubleVal;
+            return ss.str();
+        }
+    }
+    return "";
+}
+
+bool toBool(const Value& v) {
+    switch (v.type) {
+        case Value::BOOL:   return v.boolVal;
+        case Value::DOUBLE: return v.doubleVal != 0.0;
+        case Value::STRING: return !v.stringVal.empty();
+    }
+    return false;
+}
+
+Value parseValue(const std::string& text) {
+    try {
+        size_t used = 0;
+        double d = std::stod(text, &used);
+        if (used == text.size()) return Value(d);
+    } catch (...) {}
+    return Value(text);
+}
+
+int VariableTable::slot(const std::string& name) {
+    auto it = index.find(name);
+    if (it != index.end()) return it->second;
+    int s = (int)names.size();
+    names.push_back(name);
+    values.push_back(Value());
+    visible.push_back(true);
+    index[name] = s;
+    return s;
+}
+
+int VariableTable::find(const std::string& name) const {
+    auto it = index.find(name);
+    return it != index.end() ? it->second : -1;
+}
+
+void VariableTable::set(const std::string& name, const Value& v) {
+    values[slot(name)] = v;
+}
+
+void VariableTable::clear() {
+    names.clear();
+    values.clear();
+    visible.clear();
+    index.clear();
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+Program::Program() {}
+void Program::clear() {
+    code.clear();
+    scripts.clear();
+    onFlag.clear();
+    onKey.clear();
+    onMessage.clear();
+    onClick.clear();
+    messages.clear();
+    messageIds.clear();
+    ordered.clear();
+}
+
+int Program::message(const std::string& name) {
+    auto it = messageIds.find(name);
+    if (it != messageIds.end()) return it->second;
+    int id = (int)messages.size();
+    messages.push_back(name);
+    onMessage.push_back({});
+    messageIds[name] = id;
+    return id;
+}
 
 // ─────────────────────────────────────────────────────────────────────────────
 Costume::Costume() : texture(nullptr), width(64), height(64) {}
 
+// ─────────────────────────────────────────────────────────────────────────────
+int SpriteTable::add() {
+    x.push_back(0);
+    y.push_back(0);
+    direction.push_back(90); // facing right (Scratch convention: 90 = right)
+    size.push_back(100.0f);  // 100%
+    visible.push_back(1);
+    // New sprites go in front of every existing one, as in Scratch
+    int front = drawOrder.empty() ? 0 : drawOrder.rbegin()->first + 1;
+    layer.push_back(front);
+    drawOrder.insert({front, count() - 1});
+    return count() - 1;
+}
+
+void SpriteTable::clear() {
+    x.clear(); y.clear(); direction.clear(); size.clear();
+    visible.clear(); layer.clear();
+    drawOrder.clear();
+}
+
+void SpriteTable::setLayer(int id, int value) {
+    if (layer[id] == value) return;
+    drawOrder.erase({layer[id], id});
+    layer[id] = value;
+    drawOrder.insert({value, id});
+}
+
+void SpriteTable::toFront(int id) {
+    if (drawOrder.rbegin()->second != id) setLayer(id, drawOrder.rbegin()->first + 1);
+}
+
+void SpriteTable::toBack(int id) {
+    if (drawOrder.begin()->second != id) setLayer(id, drawOrder.begin()->first - 1);
+}
+
+// Layer numbers between neighbours after a renumber, room for later moves
+static const int LAYER_GAP = 16;
+
+void SpriteTable::moveLayers(int id, int n) {
+    bool forward = n > 0;
+    auto self = drawOrder.find({layer[id], id});
+    auto past = self; // nth neighbour in the direction of travel, clamped at the ends
+    if (forward) for (; n > 0 && std::next(past) != drawOrder.end(); n--) ++past;
+    else         for (; n < 0 && past != drawOrder.begin(); n++) --past;
+    if (past == self) return;
+
+    // Just beyond that neighbour, if the layer there is still free
+    int value = forward ? past->first + 1 : past->first - 1;
+    bool free = forward ? (std::next(past) == drawOrder.end() || value < std::next(past)->first)
+                        : (past == drawOrder.begin() || value > std::prev(past)->first);
+    if (free) { setLayer(id, value); return; }
+
+    // Taken: renumber the whole order with `id` moved next to the neighbour
+    int neighbour = past->second;
+    std::vector<int> ids;
+    ids.reserve(drawOrder.size());
+    for (const auto& e : drawOrder) {
+        if (e.second == id) continue;
+        if (!forward && e.second == neighbour) ids.push_back(id);
+        ids.push_back(e.second);
+        if (forward && e.second == neighbour) ids.push_back(id);
+    }
+    drawOrder.clear();
+    for (int i = 0; i < (int)ids.size(); i++) {
+        layer[ids[i]] = i * LAYER_GAP;
+        drawOrder.insert({layer[ids[i]], ids[i]});
+    }
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 Sprite::Sprite() {
-    name = "Sprite"; x = 0; y = 0;
-    direction = 90; // facing right (Scratch convention: 90 = right)
-    size = 100.0f;  // 100%
-    visible = true; layer = 0;
+    name = "Sprite"; id = -1;
     currentCostume = 0; isThinking = false; sayTimer = 0;
     penDown = false;
     penColor = {0, 0, 200, 255};
     penSize = 2;
     colorEffect = 0; ghostEffect = 0; brightnessEffect = 0; saturationEffect = 0;
     isDraggable = true;
+    rng = 0;
 }
 Sprite::~Sprite() {
     for (auto& c : costumes)
         if (c.texture) SDL_DestroyTexture(c.texture);
+    for (auto* b : scripts) delete b;
+}
+void* Sprite::operator new(size_t size) {
+    MemStats::add(MemStats::MEM_Sprites, (long long)size);
+    return ::operator new(size);
+}
+void Sprite::operator delete(void* p, size_t size) {
+    MemStats::remove(MemStats::MEM_Sprites, (long long)size);
+    ::operator delete(p);
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -38,11 +227,51 @@ PenStroke::PenStroke() : size(2) { color = {0, 0, 200, 255}; }
 
 // ─────────────────────────────────────────────────────────────────────────────
 SpriteExecCtx::SpriteExecCtx()
-    : pc(0), waitTimer(0), waitUntilActive(false),
-      askWaiting(false), finished(false) {}
+    : script(-1), pc(0), waitTimer(0), waitUntilActive(false),
+      askWaiting(false), waitMessage(-1), watchdog(0), finished(false) {}
+
+void DeferredWrites::resize(int slots) {
+    vars.resize(slots);
+    wrote.resize(slots, 0);
+}
+void DeferredWrites::clear() {
+    for (const VarWrite& w : varLog) wrote[w.slot] = 0;
+    varLog.clear();
+    ops.clear();
+}
 
 ExecutionContext::ExecutionContext()
-    : running(false), paused(false), globalTimer(0) {}
+    : running(false), paused(false), globalTimer(0), tick(0), mouseWasDown(false),
+      turbo(false), frameTime(1.0f / 30), passLimit(0), parallel(false), deferShared(false) {}
+
+// ─── palette index ───────────────────────────────────────────────────────────
+void PaletteIndex::rebuild(const std::vector<Block*>& blocks) {
+    for (auto& l : lists) l.clear();
+    maxHeight = 0;
+    for (Block* b : blocks) {
+        if (b->category >= 0 && b->category < CAT_COUNT) lists[b->category].push_back(b);
+        lists[CAT_COUNT].push_back(b);
+        maxHeight = std::max(maxHeight, b->height);
+    }
+    // Stable: blocks at the same y keep palette order (later ones on top)
+    for (auto& l : lists)
+        std::stable_sort(l.begin(), l.end(), [](const Block* a, const Block* b) { return a->y < b->y; });
+}
+
+const std::vector<Block*>& PaletteIndex::list(int category) const {
+    return lists[category >= 0 && category < CAT_COUNT ? category : CAT_COUNT];
+}
+
+std::pair<size_t, size_t> PaletteIndex::visible(int category, int top, int bottom) const {
+    const std::vector<Block*>& l = list(category);
+    // A block starting above `top` can still reach into the window by its height
+    auto first = std::lower_bound(l.begin(), l.end(), top - maxHeight,
+                                  [](const Block* b, int y) { return b->y < y; });
+    while (first != l.end() && (*first)->y + (*first)->height <= top) ++first;
+    auto last = std::lower_bound(first, l.end(), bottom,
+                                 [](const Block* b, int y) { return b->y < y; });
+    return {(size_t)(first - l.begin()), (size_t)(last - l.begin())};
+}
 
 // ─────────────────────────────────────────────────────────────────────────────
 GameState::GameState() {
@@ -85,8 +314,11 @@ GameState::GameState() {
     greenFlagClicked   = false;
     stopClicked        = false;
     isDrawingStroke    = false;
+    penLayer           = nullptr;
+    penStrokesDrawn    = 0;
+    penLiveDrawn       = 0;
+    penLayerStale      = false;
 
-    watchdogCounter    = 0;
     stepMode           = false;
     stepNext           = false;
     paletteCategory    = -1;
@@ -106,3 +338,74 @@ GameState::~GameState() {
     for (auto* b : editorBlocks)  delete b;
     if (backdropTexture) SDL_DestroyTexture(backdropTexture);
 }
+
+// ─── sprite table ────────────────────────────────────────────────────────────
+int GameState::addSprite(Sprite* sp) {
+    sp->id = spriteData.add();
+    sprites.push_back(sp);
+    return sp->id;
+}
+
+void GameState::clearSprites() {
+    for (auto* s : sprites) delete s;
+    sprites.clear();
+    spriteData.clear();
+    exec.ctx.clear();
+    program.clear(); // scripts point at the old sprites
+}
+
+// ─── sprite workspaces ───────────────────────────────────────────────────────
+// The selected sprite's blocks are parked in editorBlocks (its own scripts
+// vector stays empty); every other sprite keeps them in Sprite::scripts.
+void GameState::selectSprite(int index) {
+    if (index == selectedSpriteIndex) return;
+    if (index < 0 || index >= (int)sprites.size()) return;
+    if (selectedSpriteIndex >= 0 && selectedSpriteIndex < (int)sprites.size())
+        sprites[selectedSpriteIndex]->scripts.swap(editorBlocks);
+    selectedSpriteIndex = index;
+    editorBlocks.swap(sprites[index]->scripts);
+}
+
+std::vector<Block*>& GameState::scriptsOf(Sprite* sp) {
+    bool selected = selectedSpriteIndex >= 0 && selectedSpriteIndex < (int)sprites.size() &&
+                    sprites[selectedSpriteIndex] == sp;
+    return selected ? editorBlocks : sp->scripts;
+}
+
+const std::vector<Block*>& GameState::scriptsOf(const Sprite* sp) const {
+    bool selected = selectedSpriteIndex >= 0 && selectedSpriteIndex < (int)sprites.size() &&
+                    sprites[selectedSpriteIndex] == sp;
+    return selected ? editorBlocks : sp->scripts;
+}
+
+void GameState::clearScripts() {
+    for (auto* b : editorBlocks) delete b;
+    editorBlocks.clear();
+    for (auto* sp : sprites) {
+        for (auto* b : sp->scripts) delete b;
+        sp->scripts.clear();
+    }
+    program.clear();
+}
+
+void GameState::detachBlock(Block* b) {
+    for (Block* other : editorBlocks)
+        if (other->nextBlock == b) other->nextBlock = nullptr;
+}
+
+void GameState::deleteBlock(Block* b) {
+    Block* next = b->nextBlock == b ? nullptr : b->nextBlock;
+    for (Block* other : editorBlocks)
+        if (other->nextBlock == b) other->nextBlock = next == other ? nullptr : next;
+    editorBlocks.erase(std::remove(editorBlocks.begin(), editorBlocks.end(), b), editorBlocks.end());
+    if (snapTarget == b)   snapTarget   = nullptr;
+    if (draggedBlock == b) draggedBlock = nullptr;
+    delete b;
+}
+
+// ─── pen ─────────────────────────────────────────────────────────────────────
+void GameState::clearPen() {
+    penStrokes.clear();
+    isDrawingStroke = false;
+    penLayerStale   = true;
+}
@@ -2,6 +2,9 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
+#include <memory>
+#include <functional>
 #include <SDL2/SDL.h>
 
 
@@ -60,13 +63,16 @@ enum BlockType {
     BLOCK_Stamp,
     // Internal
     BLOCK_Literal,
+    // Compiled control flow (emitted by Compiler, never shown in editor)
+    OP_Jump, OP_LoopNext, OP_LoopBack, OP_Halt,
     BLOCK_None
 };
 
 enum BlockCategory {
     CAT_MOTION, CAT_LOOKS, CAT_SOUND, CAT_EVENTS,
     CAT_CONTROL, CAT_SENSING, CAT_OPERATORS,
-    CAT_VARIABLES, CAT_PEN
+    CAT_VARIABLES, CAT_PEN,
+    CAT_COUNT
 };
 
 
@@ -84,28 +90,139 @@ struct Block {
     std::vector<Block*> nested;   // if-body / repeat-body
     std::vector<Block*> nested2;  // else-body (IfElse only)
     bool selected, isDragging;
-    // Pre-scan jump targets (indices into flat editorBlocks)
+    // Pre-scan jump targets (indices into compiled Program::code)
     int jumpTarget;
     int elseTarget;
+    int varSlot;                  // resolved variable slot (-1 = none)
+    // Expression folding (preScan)
+    bool   pure;                  // reporter result depends only on its inputs
+    bool   constant;              // result known before the script runs
+    double constNum;              // folded value as a number
+    bool   constBool;             // folded value as a condition
     Block();
     ~Block();
+    // Heap blocks are counted under MemStats::MEM_Blocks
+    static void* operator new(size_t size);
+    static void  operator delete(void* p, size_t size);
+};
+
+
+// Variables
+
+// Tagged variable value; only turned into text for monitors / saving
+struct Value {
+    enum Type { DOUBLE, STRING, BOOL } type;
+    double      doubleVal;
+    std::string stringVal;
+    bool        boolVal;
+
+    Value()                     : type(DOUBLE), doubleVal(0), boolVal(false) {}
+    Value(double v)             : type(DOUBLE), doubleVal(v), boolVal(false) {}
+    Value(const std::string& v) : type(STRING), doubleVal(0), stringVal(v), boolVal(false) {}
+    Value(const char* v)        : type(STRING), doubleVal(0), stringVal(v), boolVal(false) {}
+    Value(bool v)               : type(BOOL),   doubleVal(0), boolVal(v) {}
+};
+
+double      toDouble(const Value& v);
+std::string toString(const Value& v);
+bool        toBool  (const Value& v);
+Value       parseValue(const std::string& text); // number if it parses, else string
+
+// Slot-indexed variable storage; names are resolved to slots by preScan
+struct VariableTable {
+    std::vector<std::string> names;
+    std::vector<Value>       values;
+    std::vector<bool>        visible;
+    std::map<std::string, int> index; // name -> slot
+
+    int  slot(const std::string& name);       // find or create
+    int  find(const std::string& name) const; // -1 if unknown
+    void set (const std::string& name, const Value& v);
+    int  size()  const { return (int)names.size(); }
+    bool empty() const { return names.empty(); }
+    void clear();
+};
+
+
+// Compiled script (filled by Engine::preScan)
+
+struct Instr {
+    BlockType    op;        // block type or OP_* control code
+    int          target;    // resolved jump target (-1 = none)
+    double       num[2];    // pre-decoded literal operands
+    const Block* arg[2];    // operand expressions (nullptr = use num)
+    const Block* src;       // editor block this was lowered from
+    int          var;       // variable slot for Set/ChangeVariable (-1 = none)
+    int          msg;       // message id for Broadcast(AndWait) (-1 = none)
+    Instr();
+};
+
+struct Sprite;
+
+struct ScriptEntry {
+    BlockType   hat;        // WhenFlagClicked, WhenKeyPressed, ...
+    std::string key;        // key / message name of the hat
+    int         entry;      // first instruction after the hat
+    Sprite*     sprite;     // sprite that owns the script
+};
+
+struct Program {
+    std::vector<Instr>       code;
+    std::vector<ScriptEntry> scripts;
+    // Event dispatch index: listeners per event, as indices into scripts
+    std::vector<int>                          onFlag;
+    std::map<std::string, std::vector<int>>   onKey;
+    std::vector<std::vector<int>>             onMessage; // by message id
+    std::map<const Sprite*, std::vector<int>> onClick;
+    // Interned broadcast message names
+    std::vector<std::string>   messages;
+    std::map<std::string, int> messageIds;
+    // By Sprite::id: reads what another sprite writes or stops all, so a
+    // parallel pass steps it alone and in sprite order
+    std::vector<char> ordered;
+    int message(const std::string& name); // find or create
+    Program();
+    void clear();
 };
 
 
 // Costume / Sprite
 
+// ARGB8888 copy of a costume's source image, the input for graphic effects
+struct CostumePixels {
+    int w, h;
+    std::vector<Uint32> argb;
+};
+
 struct Costume {
     std::string  name;
     SDL_Texture* texture;
     int width, height;
+    std::shared_ptr<const CostumePixels> pixels; // null: effects not applied
     Costume();
 };
 
+// Hot per-sprite state as struct-of-arrays, indexed by Sprite::id, so the
+// engine, renderer and collision checks stream through contiguous columns
+struct SpriteTable {
+    std::vector<float> x, y, direction, size; // size in %
+    std::vector<char>  visible;
+    std::vector<int>   layer;
+    // Stage draw order, back to front: (layer, id) kept sorted as layers
+    // change, so the renderer never sorts
+    std::set<std::pair<int, int>> drawOrder;
+    int  add();                               // new row with defaults, returns its id
+    int  count() const { return (int)x.size(); }
+    void clear();
+    void setLayer(int id, int value);         // O(log n)
+    void toFront(int id);
+    void toBack(int id);
+    void moveLayers(int id, int n);           // past n neighbours, forward if n > 0
+};
+
 struct Sprite {
     std::string name;
-    float x, y, direction, size; // size in %
-    bool  visible;
-    int   layer;
+    int   id;            // dense index into GameState::sprites / spriteData (-1 = not added)
     std::vector<Costume> costumes;
     int   currentCostume;
     // Speech
@@ -124,10 +241,28 @@ struct Sprite {
     // Sensing / interaction
     bool  isDraggable;
     std::string answer; // last ask-answer
-    // Scripts attached to this sprite
+    unsigned rng;        // random stream state, seeded at the green flag
+    // Top-level blocks of this sprite's workspace. While the sprite is
+    // selected they live in GameState::editorBlocks instead.
     std::vector<Block*> scripts;
     Sprite();
     ~Sprite();
+    // Heap sprites are counted under MemStats::MEM_Sprites
+    static void* operator new(size_t size);
+    static void  operator delete(void* p, size_t size);
+};
+
+// Palette blocks grouped per category (plus one list of all), each sorted
+// by y, so drawing and hit-testing binary-search the scrolled window
+// instead of filtering every block
+struct PaletteIndex {
+    std::vector<Block*> lists[CAT_COUNT + 1]; // [CAT_COUNT] = all categories
+    int maxHeight = 0;
+    void rebuild(const std::vector<Block*>& blocks);
+    const std::vector<Block*>& list(int category) const; // -1 = all
+    // [first, last) of list(category) covering every block that overlaps
+    // rows [top, bottom); may include a few blocks ending just above top
+    std::pair<size_t, size_t> visible(int category, int top, int bottom) const;
 };
 
 // Pen layer
@@ -140,28 +275,66 @@ struct PenStroke {
 };
 
 
-// Per-sprite execution context
+// Script thread: one running hat script of a sprite
 
 struct SpriteExecCtx {
-    int  pc;                        // index into editorBlocks for THIS sprite
-    std::vector<int>  loopCount;    // repeat counter stack
-    std::vector<int>  loopStart;    // loop-start pc stack
+    int  script;                    // index into Program::scripts
+    int  pc;                        // index into Program::code for THIS thread
+    // Loop frame stack: one entry per active repeat, so a loop can yield
+    // at the end of an iteration and resume on the next tick
+    std::vector<int>  loopCount;    // iterations left
+    std::vector<int>  loopStart;    // pc of the loop head
     float waitTimer;                // seconds remaining in a wait
     bool  waitUntilActive;
     bool  askWaiting;
+    int   waitMessage;              // broadcast-and-wait: message id (-1 = none)
+    int   watchdog;                 // instructions run since this thread last yielded
     bool  finished;
     SpriteExecCtx();
 };
 
 
+// Shared-state writes of one sprite during a parallel pass, committed in
+// sprite order once every worker is done
+
+struct GameState;
+
+struct VarWrite {
+    int   slot;
+    bool  delta;     // "change by": value.doubleVal is added on commit
+    Value value;
+};
+
+struct DeferredWrites {
+    std::vector<Value>    vars;                        // this sprite's view, by variable slot
+    std::vector<char>     wrote;                       // by slot: vars[slot] holds a write
+    std::vector<VarWrite> varLog;                      // variable writes, in program order
+    std::vector<std::function<void(GameState&)>> ops;  // other shared effects, in program order
+    void resize(int slots);
+    void clear();
+};
+
+
 // Global execution context
 
 struct ExecutionContext {
     bool running;
     bool paused;
-    std::map<Sprite*, SpriteExecCtx> ctx; // one ctx per sprite
+    std::vector<std::vector<SpriteExecCtx>> ctx; // running threads, by Sprite::id
     float globalTimer;
-    std::string pendingBroadcast;
+    unsigned tick;                          // engine ticks since the green flag
+    std::vector<int> broadcastQueue;        // message ids posted this tick
+    std::map<std::string, bool> keyWasDown; // edge detection for key hats
+    bool  mouseWasDown;                     // edge detection for click hats
+    // Scheduler: threads get repeated passes until a share of the frame is used
+    bool  turbo;                            // spend the whole frame, ignore redraws
+    float frameTime;                        // seconds per tick the budget comes from
+    int   passLimit;                        // > 0: fixed passes per tick, no time budget
+    // Parallel mode: independent sprites step on the worker pool, shared
+    // writes deferred (see Program::ordered)
+    bool parallel;
+    bool deferShared;                       // inside a parallel run of sprites
+    std::vector<DeferredWrites> writes;     // by Sprite::id
     ExecutionContext();
 };
 
@@ -186,13 +359,13 @@ struct GameState {
     std::vector<StageColor> stageColors;
     int currentColorIndex;
 
-    // Sprites
+    // Sprites: sprites[id]->id == id; hot transform data lives in spriteData
     std::vector<Sprite*> sprites;
+    SpriteTable          spriteData;
     int selectedSpriteIndex;
 
-    // Variables (dynamic typed: stored as string, interpreted as needed)
-    std::map<std::string, std::string> variables;
-    std::map<std::string, bool>        variableVisible;
+    // Variables (typed values in slots, see VariableTable)
+    VariableTable variables;
 
     // Execution engine
     ExecutionContext exec;
@@ -201,12 +374,19 @@ struct GameState {
     std::vector<PenStroke> penStrokes;
     PenStroke currentStroke;
     bool      isDrawingStroke;
+    // Strokes are rasterized once into penLayer (Renderer::renderPen)
+    SDL_Texture* penLayer;        // stage-sized render target, released by main before the renderer
+    size_t       penStrokesDrawn; // penStrokes[0..n) already in penLayer
+    size_t       penLiveDrawn;    // currentStroke points already in penLayer; 0 on a new stroke
+    bool         penLayerStale;   // wipe and replay penStrokes on next render
 
     // Block palette (left panel, never executed directly)
     std::vector<Block*> paletteBlocks;
+    PaletteIndex        paletteIndex; // rebuilt whenever paletteBlocks changes
 
-    // Editor (centre panel, user-assembled script)
+    // Editor (centre panel): workspace of the selected sprite
     std::vector<Block*> editorBlocks; // top-level blocks only
+    Program program;                  // all sprites' scripts lowered by preScan
 
     // Drag & drop
     Block* draggedBlock;
@@ -220,10 +400,6 @@ struct GameState {
     bool mousePressed;
     bool greenFlagClicked, stopClicked;
 
-    // Safety: watchdog counter
-    int watchdogCounter;
-    static const int WATCHDOG_LIMIT = 2000;
-
     // Debug step-mode
     bool stepMode;
     bool stepNext;
@@ -246,6 +422,21 @@ struct GameState {
     // Pen extension active?
     bool penExtensionActive;
 
+    // Sprite registration: assigns the dense id and a spriteData row
+    int  addSprite(Sprite* sp);
+    void clearSprites();              // delete every sprite
+
+    // Workspace switching: editorBlocks always shows the selected sprite
+    void selectSprite(int index);
+    std::vector<Block*>&       scriptsOf(Sprite* sp);
+    const std::vector<Block*>& scriptsOf(const Sprite* sp) const;
+    void clearScripts();              // delete every sprite's blocks
+    // Editor block chains: detach cuts `b` off whatever block chains to it;
+    // delete also relinks that block to b->nextBlock and frees `b`
+    void detachBlock(Block* b);
+    void deleteBlock(Block* b);
+    void clearPen();                  // erase all strokes and the pen layer
+
     GameState();
     ~GameState();
 };
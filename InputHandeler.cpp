@@ -1,12 +1,22 @@
 #include "InputHandler.h"
 #include "Engine.h"
 #include "Logger.h"
+#include "FrameStats.h"
+#include "MemStats.h"
+#include "Profiler.h"
+#include "Timeline.h"
 #include "UIManager.h"
 #include <iostream>
 #include <cmath>
 
 namespace Input {
 
+static std::function<void(GameState&)> profileReport;
+
+void setProfileReport(std::function<void(GameState&)> report) {
+    profileReport = std::move(report);
+}
+
 void handleEvent(GameState& state, SDL_Event& event) {
     switch (event.type) {
         case SDL_MOUSEBUTTONDOWN:
@@ -21,6 +31,9 @@ void handleEvent(GameState& state, SDL_Event& event) {
         case SDL_KEYDOWN:
             handleKeyPress(state, event.key.keysym.sym);
             break;
+        case SDL_RENDER_TARGETS_RESET:
+            state.penLayerStale = true; // target contents were lost
+            break;
         case SDL_TEXTINPUT:
             if (state.askActive) {
                 state.askInput += event.text.text;
@@ -44,12 +57,13 @@ void handleMouseDown(GameState& state, int x, int y) {
     if (x < state.paletteWidth && y > palClickMinY) {
         // Find block accounting for scroll offset
         // Each block's stored .y is its base position; rendered as y - paletteScrollY
+        // Candidates come from the category's y-sorted list; top-most wins
         Block* clicked = nullptr;
-        for (int i = (int)state.paletteBlocks.size()-1; i >= 0; i--) {
-            Block* b = state.paletteBlocks[i];
-            // category filter
-            if (state.paletteCategory >= 0 && (int)b->category != state.paletteCategory)
-                continue;
+        const std::vector<Block*>& blocks = state.paletteIndex.list(state.paletteCategory);
+        int py = y + state.paletteScrollY;
+        auto range = state.paletteIndex.visible(state.paletteCategory, py, py + 1);
+        for (size_t i = range.second; i-- > range.first; ) {
+            Block* b = blocks[i];
             int drawY = b->y - state.paletteScrollY;
             if (x >= b->x && x < b->x + b->width &&
                 y >= drawY  && y < drawY + b->height) {
@@ -85,6 +99,8 @@ void handleMouseDown(GameState& state, int x, int y) {
     if (x >= state.editorX && x < state.stageX && y > 35) {
         Block* clicked = findBlockAt(state.editorBlocks, x, y);
         if (clicked) {
+            // Dragging a block out of a stack ends the stack above it
+            state.detachBlock(clicked);
             state.draggedBlock        = clicked;
             state.draggingFromPalette = false;
             state.dragOffsetX         = x - clicked->x;
@@ -135,9 +151,10 @@ void handleMouseUp(GameState& state, int x, int y) {
 
         // If dropped back in palette, delete it from editor
         if (x < state.paletteWidth) {
-            auto& eb = state.editorBlocks;
-            eb.erase(std::remove(eb.begin(), eb.end(), state.draggedBlock), eb.end());
-            delete state.draggedBlock;
+            state.deleteBlock(state.draggedBlock);
+            // compiled code may point at the deleted block
+            state.exec.running = false;
+            state.program.clear();
         }
     }
 
@@ -196,14 +213,76 @@ void handleKeyPress(GameState& state, SDL_Keycode key) {
             }
             break;
 
+        case SDLK_p:
+            // Parallel sprite execution toggle
+            state.exec.parallel = !state.exec.parallel;
+            Logger::info(state.exec.parallel ? "Parallel execution ON" : "Parallel execution OFF");
+            break;
+
+        case SDLK_t:
+            // Turbo mode: scripts may use the whole frame and ignore redraws
+            state.exec.turbo = !state.exec.turbo;
+            Logger::info(state.exec.turbo ? "Turbo mode ON" : "Turbo mode OFF");
+            break;
+
+        case SDLK_F3:
+            Profiler::setEnabled(!Profiler::isEnabled());
+            Logger::info(Profiler::isEnabled() ? "Profiler ON" : "Profiler OFF");
+            break;
+
+        case SDLK_F4:
+            if (profileReport) profileReport(state);
+            break;
+
+        case SDLK_F5:
+            FrameStats::showOverlay = !FrameStats::showOverlay;
+            break;
+
+        case SDLK_F6:
+            // Periodic frame timing summary in the log
+            FrameStats::logInterval = FrameStats::logInterval > 0 ? 0 : 10;
+            Logger::info(FrameStats::logInterval > 0 ? "Frame stats logging ON (10s)"
+                                                     : "Frame stats logging OFF");
+            break;
+
+        case SDLK_F7: {
+            // Live memory report; the log gets a copy
+            MemStats::showOverlay = !MemStats::showOverlay;
+            if (MemStats::showOverlay)
+                for (auto& line : MemStats::describe(MemStats::snapshot(state)))
+                    Logger::info("Memory: " + line);
+            break;
+        }
+
+        case SDLK_F8:
+            Timeline::recording = !Timeline::recording;
+            Logger::info(Timeline::recording ? "Timeline recording ON" : "Timeline recording OFF");
+            break;
+
+        case SDLK_F9:
+            // Last Timeline::windowSeconds as Chrome trace JSON
+            if (Timeline::recording) Timeline::capture();
+            break;
+
+        case SDLK_l: {
+            // Per-block trace logging (engine and pen DEBUG messages)
+            bool on = !Logger::enabled(Logger::Category::Engine, Logger::Level::DEBUG_LVL);
+            Logger::Level lvl = on ? Logger::Level::DEBUG_LVL : Logger::Level::INFO;
+            Logger::setLevel(Logger::Category::Engine, lvl);
+            Logger::setLevel(Logger::Category::Pen,    lvl);
+            Logger::info(on ? "Block trace logging ON" : "Block trace logging OFF");
+            break;
+        }
+
         case SDLK_DELETE:
         case SDLK_BACKSPACE: {
             // Delete selected blocks from editor
             auto& eb = state.editorBlocks;
             for (int i = (int)eb.size()-1; i >= 0; i--) {
                 if (eb[i]->selected) {
-                    delete eb[i];
-                    eb.erase(eb.begin() + i);
+                    state.deleteBlock(eb[i]);
+                    state.exec.running = false;
+                    state.program.clear();
                 }
             }
             break;
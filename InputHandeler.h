@@ -1,6 +1,7 @@
 #pragma once
 #include "GameState.h"
 #include <algorithm>
+#include <functional>
 
 namespace Input {
     void handleEvent(GameState& state, SDL_Event& event);
@@ -8,6 +9,8 @@ namespace Input {
     void handleMouseUp    (GameState& state, int x, int y);
     void handleMouseMotion(GameState& state, int x, int y);
     void handleKeyPress   (GameState& state, SDL_Keycode key);
+    // F4: show the profiler report (the app owns the panel it goes to)
+    void setProfileReport (std::function<void(GameState&)> report);
 
     Block* findBlockAt   (const std::vector<Block*>& blocks, int x, int y);
     Block* findSnapTarget(GameState& state);
@@ -1,49 +1,216 @@
 #include "Logger.h"
+#include "MemStats.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <mutex>
+#include <thread>
 
 namespace Logger {
-    static std::ofstream logFile;
-    static bool initialized = false;
+    // ─── record ring ─────────────────────────────────────────────────────────
+    // Bounded multi-producer queue: each cell carries a sequence number that
+    // says whose turn it is, so producers claim cells with one CAS and the
+    // writer thread never takes a lock. When the ring is full new records
+    // are dropped and counted instead of stalling the engine.
+    static const int    RING_SIZE = 4096;   // power of two
+    static const size_t TEXT_MAX  = 240;    // longer messages are truncated
+
+    struct Record {
+        std::atomic<size_t> seq;
+        Level    level;
+        Category category;
+        time_t when;
+        int    length;
+        bool   truncated;
+        char   text[TEXT_MAX];
+    };
+
+    static Record              ring[RING_SIZE];
+    static std::atomic<size_t> head(0);    // next cell to claim (producers)
+    static size_t              tail = 0;   // next cell to write out (writer only)
+    static std::atomic<long>   dropped(0);
+
+    static std::ofstream           logFile;
+    static std::thread             writer;
+    static std::mutex              wakeMutex;
+    static std::condition_variable wakeWriter;
+    static std::atomic<bool>       running(false);
+    static bool                    initialized = false;
+
+    // Per-block and per-frame traces are DEBUG, so they cost one branch by default
+    std::atomic<Level> threshold[(int)Category::Count] = {
+        {Level::INFO}, {Level::INFO}, {Level::INFO}, {Level::INFO}, {Level::INFO}
+    };
+
+    static const char* prefixOf(Level level) {
+        switch (level) {
+            case Level::DEBUG_LVL: return "[DEBUG] ";
+            case Level::INFO:      return "[INFO] ";
+            case Level::WARNING:   return "[WARN] ";
+            case Level::ERROR_LVL: return "[ERROR] ";
+        }
+        return "";
+    }
+
+    static const char* tagOf(Category category) {
+        switch (category) {
+            case Category::Engine:   return "[Engine] ";
+            case Category::Pen:      return "[Pen] ";
+            case Category::Renderer: return "[Renderer] ";
+            case Category::IO:       return "[IO] ";
+            default:                 return "";
+        }
+    }
+
+    static void formatTime(time_t when, char* buf, size_t size) {
+        strftime(buf, size, "%Y-%m-%d %H:%M:%S", localtime(&when));
+    }
 
     std::string getTime() {
-        time_t now = time(0);
-        char buf[80];
-        strftime(buf, 80, "%Y-%m-%d %H:%M:%S", localtime(&now));
+        char buf[32];
+        formatTime(time(nullptr), buf, sizeof buf);
         return buf;
     }
 
+    static bool push(Category category, Level level, const std::string& message) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        Record* r;
+        for (;;) {
+            r = &ring[pos & (RING_SIZE - 1)];
+            size_t seq = r->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+        r->level     = level;
+        r->category  = category;
+        r->when      = time(nullptr);
+        r->length    = (int)std::min(message.size(), TEXT_MAX);
+        r->truncated = message.size() > TEXT_MAX;
+        memcpy(r->text, message.data(), r->length);
+        r->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // ─── writer thread ───────────────────────────────────────────────────────
+    // Drains everything published so far into one batch; returns false when
+    // the ring was empty
+    static bool drain(std::string& batch) {
+        static time_t cachedSecond = -1;
+        static char   cachedStamp[32];
+
+        batch.clear();
+        for (;;) {
+            Record& r = ring[tail & (RING_SIZE - 1)];
+            if (r.seq.load(std::memory_order_acquire) != tail + 1) break;
+
+            if (r.when != cachedSecond) { // one strftime per second, not per line
+                cachedSecond = r.when;
+                formatTime(r.when, cachedStamp, sizeof cachedStamp);
+            }
+            batch += cachedStamp;
+            batch += ' ';
+            batch += prefixOf(r.level);
+            batch += tagOf(r.category);
+            batch.append(r.text, r.length);
+            if (r.truncated) batch += "...";
+            batch += '\n';
+
+            r.seq.store(tail + RING_SIZE, std::memory_order_release);
+            tail++;
+        }
+
+        long lost = dropped.exchange(0);
+        if (lost > 0) {
+            batch += getTime() + " [WARN] Logger: " + std::to_string(lost) +
+                     " message(s) dropped, ring full\n";
+        }
+        return !batch.empty();
+    }
+
+    static void write(const std::string& batch) {
+        std::cout << batch << std::flush;
+        if (logFile.is_open()) logFile << batch << std::flush;
+    }
+
+    static void writerLoop() {
+        std::string batch;
+        while (running.load()) {
+            if (drain(batch)) {
+                write(batch);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeWriter.wait_for(lock, std::chrono::milliseconds(10));
+        }
+        while (drain(batch)) write(batch); // whatever was queued before close()
+    }
+
+    // ─── public API ──────────────────────────────────────────────────────────
     void init(const std::string& filename) {
+        for (size_t i = 0; i < RING_SIZE; i++) ring[i].seq.store(i);
+        head = 0;
+        tail = 0;
+
         logFile.open(filename, std::ios::app);
         if (logFile.is_open()) {
             initialized = true;
+            running     = true;
+            writer      = std::thread(writerLoop);
+            MemStats::add(MemStats::MEM_Logs, sizeof ring, 0);
+            // Early returns from main must still join the writer before
+            // static destruction (a joinable std::thread terminates)
+            static bool atExit = std::atexit(close) == 0;
+            (void)atExit;
             info("Logger started");
         }
     }
 
     void log(Level level, const std::string& message) {
-        std::string prefix;
-        switch(level) {
-            case Level::INFO: prefix = "[INFO] "; break;
-            case Level::WARNING: prefix = "[WARN] "; break;
-            case Level::ERROR_LVL: prefix = "[ERROR] "; break;
-        }
-
-        std::string msg = getTime() + " " + prefix + message;
-        std::cout << msg << std::endl;
+        log(Category::General, level, message);
+    }
 
-        if (initialized && logFile.is_open()) {
-            logFile << msg << std::endl;
-            logFile.flush();
+    void log(Category category, Level level, const std::string& message) {
+        if (!enabled(category, level)) return;
+        if (!running.load(std::memory_order_relaxed)) {
+            // Before init / after close: write straight through
+            std::cout << getTime() << " " << prefixOf(level) << tagOf(category)
+                      << message << std::endl;
+            return;
+        }
+        if (!push(category, level, message)) {
+            dropped++;
+            return;
         }
+        if (level == Level::ERROR_LVL) wakeWriter.notify_one(); // don't sit on errors
     }
 
     void info(const std::string& msg) { log(Level::INFO, msg); }
     void warning(const std::string& msg) { log(Level::WARNING, msg); }
     void error(const std::string& msg) { log(Level::ERROR_LVL, msg); }
 
+    void setLevel(Category category, Level level) {
+        threshold[(int)category].store(level, std::memory_order_relaxed);
+    }
+
     void close() {
         if (initialized) {
             info("Logger closing");
+            running = false;
+            wakeWriter.notify_one();
+            writer.join();
+            MemStats::remove(MemStats::MEM_Logs, sizeof ring, 0);
             logFile.close();
             initialized = false;
         }
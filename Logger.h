@@ -1,15 +1,50 @@
 #pragma once
+#include <atomic>
 #include <string>
 #include <fstream>
 #include <iostream>
 
 namespace Logger {
-    enum class Level { INFO, WARNING, ERROR_LVL };
+    enum class Level { DEBUG_LVL, INFO, WARNING, ERROR_LVL };
+    enum class Category { General, Engine, Pen, Renderer, IO, Count };
 
     void init(const std::string& filename = "scratch.log");
     void log(Level level, const std::string& message);
+    void log(Category category, Level level, const std::string& message);
     void info(const std::string& msg);
     void warning(const std::string& msg);
     void error(const std::string& msg);
     void close();
+
+    // Runtime threshold per category. Check it before building a message;
+    // the LOG_* macros below do that for you.
+    extern std::atomic<Level> threshold[(int)Category::Count];
+    inline bool enabled(Category category, Level level) {
+        return level >= threshold[(int)category].load(std::memory_order_relaxed);
+    }
+    void setLevel(Category category, Level level);
 }
+
+// Levels below LOG_COMPILED_LEVEL are compiled out, arguments included.
+// Release builds keep warnings and errors unless the build says otherwise.
+#ifndef LOG_COMPILED_LEVEL
+#  ifdef NDEBUG
+#    define LOG_COMPILED_LEVEL 2 // Level::WARNING
+#  else
+#    define LOG_COMPILED_LEVEL 0 // Level::DEBUG_LVL
+#  endif
+#endif
+
+// LOG_INFO(Engine, "x = " + std::to_string(x)) — the message expression is
+// only evaluated when the category logs at that level
+#define LOG_AT(cat, lvl, expr)                                                  \
+    do {                                                                        \
+        if ((int)Logger::Level::lvl >= LOG_COMPILED_LEVEL &&                    \
+            Logger::enabled(Logger::Category::cat, Logger::Level::lvl))         \
+            Logger::log(Logger::Category::cat, Logger::Level::lvl, (expr));     \
+    } while (0)
+
+#define LOG_DEBUG(cat, expr) LOG_AT(cat, DEBUG_LVL, expr)
+#define LOG_INFO(cat, expr)  LOG_AT(cat, INFO, expr)
+#define LOG_WARN(cat, expr)  LOG_AT(cat, WARNING, expr)
+#define LOG_ERROR(cat, expr) LOG_AT(cat, ERROR_LVL, expr)
@@ -0,0 +1,96 @@
+#include "MemStats.h"
+#include "GameState.h"
+#include <atomic>
+#include <cstdio>
+#include <set>
+
+namespace MemStats {
+    bool showOverlay = false;
+
+    static std::atomic<long long> counted[MEM_Count][2]; // bytes, objects
+
+    void add(Tag tag, long long bytes, long long count) {
+        counted[tag][0] += bytes;
+        counted[tag][1] += count;
+    }
+
+    void remove(Tag tag, long long bytes, long long count) {
+        counted[tag][0] -= bytes;
+        counted[tag][1] -= count;
+    }
+
+    long long Report::total() const {
+        long long sum = 0;
+        for (const Usage& u : tag) sum += u.bytes;
+        return sum;
+    }
+
+    const char* tagName(Tag tag) {
+        static const char* names[MEM_Count] = { "blocks", "sprites", "pen", "textures", "logs" };
+        return names[tag];
+    }
+
+    Report snapshot(const GameState& gs) {
+        Report r;
+        for (int t = 0; t < MEM_Count; t++)
+            r.tag[t] = { counted[t][0].load(), counted[t][1].load() };
+
+        // Sprite table columns belong to the sprites
+        const SpriteTable& st = gs.spriteData;
+        r.tag[MEM_Sprites].bytes += (long long)(
+            (st.x.capacity() + st.y.capacity() + st.direction.capacity() + st.size.capacity()) * sizeof(float) +
+            st.visible.capacity() * sizeof(char) + st.layer.capacity() * sizeof(int) +
+            st.drawOrder.size() * (sizeof(std::pair<int, int>) + 4 * sizeof(void*))); // + rb-tree node links
+
+        // Pen: stroke records plus their point buffers
+        auto strokeBytes = [](const PenStroke& s) {
+            return (long long)(s.points.capacity() * sizeof(SDL_Point));
+        };
+        Usage& pen = r.tag[MEM_Pen];
+        pen.bytes += (long long)(gs.penStrokes.capacity() * sizeof(PenStroke)) + strokeBytes(gs.currentStroke);
+        pen.count += (long long)gs.currentStroke.points.size();
+        for (const PenStroke& s : gs.penStrokes) {
+            pen.bytes += strokeBytes(s);
+            pen.count += (long long)s.points.size();
+        }
+        if (gs.penLayer) {
+            int w = 0, h = 0;
+            SDL_QueryTexture(gs.penLayer, nullptr, nullptr, &w, &h);
+            pen.bytes += (long long)w * h * 4;
+        }
+
+        // Textures: RGBA8888 estimate, shared costume textures counted once
+        Usage& tex = r.tag[MEM_Textures];
+        std::set<SDL_Texture*> seen;
+        std::set<const CostumePixels*> kept; // effect source pixels, CPU side
+        for (const Sprite* sp : gs.sprites)
+            for (const Costume& c : sp->costumes) {
+                if (c.texture && seen.insert(c.texture).second) {
+                    tex.bytes += (long long)c.width * c.height * 4;
+                    tex.count++;
+                }
+                if (c.pixels && kept.insert(c.pixels.get()).second)
+                    tex.bytes += (long long)c.pixels->argb.size() * 4;
+            }
+        if (gs.backdropTexture && seen.insert(gs.backdropTexture).second) {
+            int w = 0, h = 0;
+            SDL_QueryTexture(gs.backdropTexture, nullptr, nullptr, &w, &h);
+            tex.bytes += (long long)w * h * 4;
+            tex.count++;
+        }
+        return r;
+    }
+
+    std::vector<std::string> describe(const Report& r) {
+        std::vector<std::string> lines;
+        char buf[80];
+        for (int t = 0; t < MEM_Count; t++) {
+            snprintf(buf, sizeof buf, "%-9s %9.1f KB %8lld", tagName((Tag)t),
+                     r.tag[t].bytes / 1024.0, r.tag[t].count);
+            lines.push_back(buf);
+        }
+        snprintf(buf, sizeof buf, "%-9s %9.1f KB", "total", r.total() / 1024.0);
+        lines.push_back(buf);
+        return lines;
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <vector>
+
+struct GameState;
+
+// Memory accounting per subsystem. Blocks, sprites and log entries are
+// counted where they are allocated and freed; pen strokes, the pen layer and
+// textures are measured from the state when a snapshot is taken (texture
+// bytes are an estimate: width x height x 4).
+namespace MemStats {
+    enum Tag { MEM_Blocks, MEM_Sprites, MEM_Pen, MEM_Textures, MEM_Logs, MEM_Count };
+
+    struct Usage { long long bytes, count; };
+
+    struct Report {
+        Usage tag[MEM_Count];
+        long long total() const;
+    };
+
+    void add   (Tag tag, long long bytes, long long count = 1);
+    void remove(Tag tag, long long bytes, long long count = 1);
+
+    Report      snapshot(const GameState& gs);
+    const char* tagName(Tag tag);
+    std::vector<std::string> describe(const Report& r); // one line per tag, plus total
+
+    extern bool showOverlay; // F7: live report (Renderer::renderMemStats)
+}
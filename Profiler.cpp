@@ -0,0 +1,159 @@
+#include "Profiler.h"
+#include "SaveLoad.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+
+namespace Profiler {
+    bool active = false;
+
+    // Times are in SDL performance-counter ticks until they are reported
+    struct Stat { uint64_t count = 0, total = 0, self = 0; };
+
+    // Call path: op + 1 in each 16-bit field, root block in the low bits,
+    // 0 = no deeper frame
+    static std::vector<std::unordered_map<uint64_t, Stat>> scripts; // by script index
+
+    // Open scopes of the calling thread. A script only ever runs on one
+    // thread at a time, so each scripts[] map has a single writer.
+    struct Frame { uint64_t path; int script; Uint64 start, child; };
+    static thread_local Frame stack[MAX_DEPTH];
+    static thread_local int   depth = 0;
+
+    void setEnabled(bool on) {
+        active = on;
+        Logger::info(on ? "Profiler ON" : "Profiler OFF");
+    }
+
+    void reset(int scriptCount) {
+        scripts.assign(std::max(0, scriptCount), {});
+    }
+
+    bool enter(int script, int op) {
+        if (depth == MAX_DEPTH) return false;
+        uint64_t path;
+        if (depth == 0) {
+            if (script < 0 || script >= (int)scripts.size()) return false;
+            path = (uint64_t)(op + 1);
+        } else {
+            const Frame& parent = stack[depth - 1];
+            script = parent.script;
+            path   = parent.path | ((uint64_t)(op + 1) << (16 * depth));
+        }
+        Frame& f = stack[depth++];
+        f.path   = path;
+        f.script = script;
+        f.child  = 0;
+        f.start  = SDL_GetPerformanceCounter();
+        return true;
+    }
+
+    void leave() {
+        Frame& f = stack[--depth];
+        Uint64 elapsed = SDL_GetPerformanceCounter() - f.start;
+        Stat& s = scripts[f.script][f.path];
+        s.count++;
+        s.total += elapsed;
+        s.self  += elapsed - f.child;
+        if (depth > 0) stack[depth - 1].child += elapsed;
+    }
+
+    // ─── reporting ───────────────────────────────────────────────────────────
+    static std::string opName(int op) {
+        std::string n = SaveLoad::typeName((BlockType)op);
+        return n.empty() ? "op" + std::to_string(op) : n;
+    }
+
+    static std::vector<int> opsOf(uint64_t path) {
+        std::vector<int> ops;
+        for (; path; path >>= 16) ops.push_back((int)(path & 0xFFFF) - 1);
+        return ops;
+    }
+
+    static double ms(uint64_t ticks) {
+        return ticks * 1000.0 / SDL_GetPerformanceFrequency();
+    }
+
+    static std::string scriptLabel(const GameState& gs, int i) {
+        const ScriptEntry& se = gs.program.scripts[i];
+        std::string label = "script " + std::to_string(i) + " " + opName(se.hat);
+        if (!se.key.empty()) label += " " + se.key;
+        return label;
+    }
+
+    std::vector<std::string> summary(int top) {
+        std::map<int, Stat> byOp;
+        uint64_t all = 0;
+        for (auto& paths : scripts)
+            for (auto& kv : paths) {
+                Stat& s = byOp[opsOf(kv.first).back()];
+                s.count += kv.second.count;
+                s.total += kv.second.total;
+                s.self  += kv.second.self;
+                all     += kv.second.self;
+            }
+
+        std::vector<std::pair<int, Stat>> rows(byOp.begin(), byOp.end());
+        std::sort(rows.begin(), rows.end(),
+                  [](const std::pair<int, Stat>& a, const std::pair<int, Stat>& b) {
+                      return a.second.self > b.second.self;
+                  });
+
+        std::vector<std::string> lines;
+        for (int i = 0; i < (int)rows.size() && i < top; i++) {
+            const Stat& s = rows[i].second;
+            char buf[96];
+            snprintf(buf, sizeof buf, "%-11s %6llu %6.1fms %3d%%", // fits the console width
+                     opName(rows[i].first).c_str(), (unsigned long long)s.count,
+                     ms(s.self), all ? (int)(s.self * 100 / all) : 0);
+            lines.push_back(buf);
+        }
+        return lines;
+    }
+
+    // sprite,script,path,block,count,total_ms,self_ms — one row per call path
+    bool exportCSV(const GameState& gs, const std::string& filename) {
+        std::ofstream f(filename);
+        if (!f.is_open()) {
+            LOG_ERROR(IO, "Cannot open file for profile: " + filename);
+            return false;
+        }
+        f << "sprite,script,path,block,count,total_ms,self_ms\n";
+        for (int i = 0; i < (int)scripts.size() && i < (int)gs.program.scripts.size(); i++) {
+            for (auto& kv : scripts[i]) {
+                std::vector<int> ops = opsOf(kv.first);
+                std::string path;
+                for (int op : ops) path += (path.empty() ? "" : ";") + opName(op);
+                f << gs.program.scripts[i].sprite->name << "," << scriptLabel(gs, i) << ","
+                  << path << "," << opName(ops.back()) << "," << kv.second.count << ","
+                  << ms(kv.second.total) << "," << ms(kv.second.self) << "\n";
+            }
+        }
+        LOG_INFO(IO, "Profile CSV written to: " + filename);
+        return true;
+    }
+
+    // "sprite;script;block;reporter self_us" — input for flamegraph.pl / speedscope
+    bool exportFolded(const GameState& gs, const std::string& filename) {
+        std::ofstream f(filename);
+        if (!f.is_open()) {
+            LOG_ERROR(IO, "Cannot open file for profile: " + filename);
+            return false;
+        }
+        for (int i = 0; i < (int)scripts.size() && i < (int)gs.program.scripts.size(); i++) {
+            std::string prefix = gs.program.scripts[i].sprite->name + ";" + scriptLabel(gs, i);
+            for (auto& kv : scripts[i]) {
+                long long us = (long long)(ms(kv.second.self) * 1000.0);
+                if (us <= 0) continue;
+                f << prefix;
+                for (int op : opsOf(kv.first)) f << ";" << opName(op);
+                f << " " << us << "\n";
+            }
+        }
+        LOG_INFO(IO, "Profile stacks written to: " + filename);
+        return true;
+    }
+}
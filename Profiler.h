@@ -0,0 +1,35 @@
+#pragma once
+#include "GameState.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-block-type execution profiler. Engine opens a Scope around every
+// executed instruction (executeOneBlock) and every reporter it evaluates
+// (evalNum / evalBool); samples are keyed by script and by the call path
+// block -> reporter -> nested reporter, so the same data gives per-type
+// totals, per-sprite / per-script CSV and folded stacks for flame graphs.
+namespace Profiler {
+    const int MAX_DEPTH = 4; // reporters nested deeper count as their parent's self time
+
+    extern bool active;
+    inline bool isEnabled() { return active; }
+    void setEnabled(bool on); // toggle between ticks only
+    void reset(int scriptCount); // drop all samples (scripts were recompiled)
+
+    // Hooks. `script` is the running script for an instruction, -1 for a
+    // reporter (it inherits the script of the enclosing instruction).
+    bool enter(int script, int op);
+    void leave();
+
+    struct Scope {
+        Scope(int script, int op) : on(isEnabled() && enter(script, op)) {}
+        ~Scope() { if (on) leave(); }
+        bool on;
+    };
+
+    // One line per block type, most self time first
+    std::vector<std::string> summary(int top);
+    bool exportCSV   (const GameState& gs, const std::string& filename);
+    bool exportFolded(const GameState& gs, const std::string& filename);
+}
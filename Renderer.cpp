@@ -1,9 +1,19 @@
 #include "Renderer.h"
 #include "UIManager.h"
-// NO SDL_ttf - uses pixel font from UIManager pattern
+// NO SDL_ttf - uses the shared pixel font atlas (Font.h)
+#include "Font.h"
+#include "Effects.h"
 #include <iostream>
 #include "Logger.h"
+#include "FrameStats.h"
+#include "MemStats.h"
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
 
 namespace Renderer {
 
@@ -37,11 +47,13 @@ void renderPaletteBlocks(GameState& state) {
     SDL_Rect clip = {clipX, clipY, clipW, clipH};
     SDL_RenderSetClipRect(state.renderer, &clip);
 
-    // Category map: paletteCategory -1 = ALL, else matches BlockCategory enum
-    for (Block* block : state.paletteBlocks) {
-        // Category filter
-        if (state.paletteCategory >= 0 &&
-            (int)block->category != state.paletteCategory) continue;
+    // Category map: paletteCategory -1 = ALL, else matches BlockCategory enum.
+    // Only the blocks in the scrolled window are visited.
+    const std::vector<Block*>& blocks = state.paletteIndex.list(state.paletteCategory);
+    auto range = state.paletteIndex.visible(state.paletteCategory,
+        clipY + state.paletteScrollY, clipY + clipH + state.paletteScrollY);
+    for (size_t i = range.first; i < range.second; i++) {
+        Block* block = blocks[i];
 
         // Apply scroll: shift Y by -paletteScrollY relative to palette top
         int drawY = block->y - state.paletteScrollY;
@@ -70,115 +82,212 @@ void renderEditorBlocks(GameState& state) {
     }
 }
 
-void renderStageContent(GameState& state) {
-    // Stage background (solid color)
-    SDL_SetRenderDrawColor(state.renderer,
-        state.stageColor.r, state.stageColor.g, state.stageColor.b, 255);
-    SDL_Rect stage = {state.stageX, state.stageY, state.stageWidth, state.stageHeight};
-    SDL_RenderFillRect(state.renderer, &stage);
+// ─── Pen layer ─────────────────────────────────────────────────────────────
+// Strokes are tessellated into triangles (a quad per segment, a disc at every
+// point for round caps and joins) and submitted in one SDL_RenderGeometry
+// call per flush. Colour travels with each vertex, so strokes of any colour
+// share a batch and keep their drawing order.
+static std::vector<SDL_Vertex> penVerts;
+static std::vector<int>        penIndices;
+static const size_t PEN_BATCH_VERTS = 1 << 16; // flush threshold for full replays
+
+static void flushPen(SDL_Renderer* r) {
+    if (!penIndices.empty())
+        SDL_RenderGeometry(r, nullptr, penVerts.data(), (int)penVerts.size(),
+                           penIndices.data(), (int)penIndices.size());
+    penVerts.clear();
+    penIndices.clear();
+}
 
-    // Draw pen strokes
-    for (const PenStroke& stroke : state.penStrokes) {
-        if (stroke.points.size() < 2) continue;
+static void addDisc(float cx, float cy, float radius, SDL_Color col) {
+    int n = std::max(6, std::min(32, (int)(radius * 2)));
+    int centre = (int)penVerts.size();
+    penVerts.push_back({{cx, cy}, col, {0, 0}});
+    for (int k = 0; k < n; k++) {
+        float a = k * 2 * (float)M_PI / n;
+        penVerts.push_back({{cx + radius * std::cos(a), cy + radius * std::sin(a)}, col, {0, 0}});
+        penIndices.insert(penIndices.end(), {centre, centre + 1 + k, centre + 1 + (k + 1) % n});
+    }
+}
 
-        SDL_SetRenderDrawColor(state.renderer,
-            stroke.color.r, stroke.color.g, stroke.color.b, stroke.color.a);
+static void addSegment(float x1, float y1, float x2, float y2, float radius, SDL_Color col) {
+    float dx = x2 - x1, dy = y2 - y1;
+    float len = std::sqrt(dx * dx + dy * dy);
+    if (len == 0) return;
+    float nx = -dy / len * radius, ny = dx / len * radius;
+    int base = (int)penVerts.size();
+    penVerts.push_back({{x1 + nx, y1 + ny}, col, {0, 0}});
+    penVerts.push_back({{x2 + nx, y2 + ny}, col, {0, 0}});
+    penVerts.push_back({{x2 - nx, y2 - ny}, col, {0, 0}});
+    penVerts.push_back({{x1 - nx, y1 - ny}, col, {0, 0}});
+    penIndices.insert(penIndices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+}
 
-        for (size_t i = 1; i < stroke.points.size(); i++) {
-            int x1 = state.stageX + state.stageWidth / 2 + stroke.points[i-1].x;
-            int y1 = state.stageY + state.stageHeight / 2 - stroke.points[i-1].y;
-            int x2 = state.stageX + state.stageWidth / 2 + stroke.points[i].x;
-            int y2 = state.stageY + state.stageHeight / 2 - stroke.points[i].y;
+// Segments ending at points [from, n) of a stroke; (ox, oy) is the stage
+// centre in the target's coordinates. Width matches the old offset-line
+// pen (size/2 pixels either side); size 0 (stamp marker) is one pixel.
+static void drawStroke(SDL_Renderer* r, const PenStroke& stroke, size_t from, int ox, int oy) {
+    float radius = (2 * (stroke.size / 2) + 1) / 2.0f;
+    auto at = [&](size_t i) {
+        // +0.5: stage points sit on pixel centres
+        return SDL_FPoint{ox + stroke.points[i].x + 0.5f, oy - stroke.points[i].y + 0.5f};
+    };
+    for (size_t i = std::max<size_t>(from, 1); i < stroke.points.size(); i++) {
+        SDL_FPoint p1 = at(i - 1), p2 = at(i);
+        if (i == 1) addDisc(p1.x, p1.y, radius, stroke.color);
+        addSegment(p1.x, p1.y, p2.x, p2.y, radius, stroke.color);
+        addDisc(p2.x, p2.y, radius, stroke.color);
+    }
+    if (penVerts.size() >= PEN_BATCH_VERTS) flushPen(r);
+}
 
-            for (int t = -stroke.size/2; t <= stroke.size/2; t++) {
-                SDL_RenderDrawLine(state.renderer, x1 + t, y1, x2 + t, y2);
-                SDL_RenderDrawLine(state.renderer, x1, y1 + t, x2, y2 + t);
-            }
+// Rasterizes what was drawn since the last frame into state.penLayer.
+// A finished stroke is replayed whole once it lands in penStrokes; pen
+// colours are opaque, so redrawing its live part changes nothing.
+static bool updatePenLayer(GameState& state) {
+    static bool unsupported = false;
+    if (unsupported) return false;
+    SDL_Renderer* r = state.renderer;
+    int w = 0, h = 0;
+    if (state.penLayer) SDL_QueryTexture(state.penLayer, nullptr, nullptr, &w, &h);
+
+    bool rebuild = state.penLayerStale;
+    if (!state.penLayer || w != state.stageWidth || h != state.stageHeight) {
+        if (state.penLayer) SDL_DestroyTexture(state.penLayer);
+        state.penLayer = SDL_CreateTexture(r, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+                                           state.stageWidth, state.stageHeight);
+        if (!state.penLayer) {
+            unsupported = true;
+            LOG_WARN(Renderer, std::string("Pen layer unavailable, redrawing strokes each frame: ") + SDL_GetError());
+            return false;
         }
+        SDL_SetTextureBlendMode(state.penLayer, SDL_BLENDMODE_BLEND);
+        rebuild = true;
     }
 
-    // Draw current stroke
-    if (state.isDrawingStroke && state.currentStroke.points.size() >= 2) {
-        SDL_SetRenderDrawColor(state.renderer,
-            state.currentStroke.color.r, state.currentStroke.color.g,
-            state.currentStroke.color.b, state.currentStroke.color.a);
-
-        for (size_t i = 1; i < state.currentStroke.points.size(); i++) {
-            int x1 = state.stageX + state.stageWidth / 2 + state.currentStroke.points[i-1].x;
-            int y1 = state.stageY + state.stageHeight / 2 - state.currentStroke.points[i-1].y;
-            int x2 = state.stageX + state.stageWidth / 2 + state.currentStroke.points[i].x;
-            int y2 = state.stageY + state.stageHeight / 2 - state.currentStroke.points[i].y;
-
-            for (int t = -state.currentStroke.size/2; t <= state.currentStroke.size/2; t++) {
-                SDL_RenderDrawLine(state.renderer, x1 + t, y1, x2 + t, y2);
-                SDL_RenderDrawLine(state.renderer, x1, y1 + t, x2, y2 + t);
-            }
-        }
+    SDL_Texture* prev = SDL_GetRenderTarget(r);
+    SDL_SetRenderTarget(r, state.penLayer);
+    if (rebuild) {
+        SDL_SetRenderDrawColor(r, 0, 0, 0, 0);
+        SDL_RenderClear(r);
+        state.penStrokesDrawn = 0;
+        state.penLiveDrawn    = 0;
+        state.penLayerStale   = false;
     }
 
-    // Render sprite
-    if (state.selectedSpriteIndex >= 0 &&
-        state.selectedSpriteIndex < (int)state.sprites.size()) {
-
-        Sprite* sprite = state.sprites[state.selectedSpriteIndex];
-
-        if (sprite->visible && !sprite->costumes.empty()) {
-            Costume& costume = sprite->costumes[sprite->currentCostume];
-
-            int screenX = state.stageX + state.stageWidth / 2 + (int)sprite->x;
-            int screenY = state.stageY + state.stageHeight / 2 - (int)sprite->y;
-
-            int w = (int)(costume.width * sprite->size / 100.0f);
-            int h = (int)(costume.height * sprite->size / 100.0f);
-
-            SDL_Rect dst = {screenX - w/2, screenY - h/2, w, h};
-
-            double angle = sprite->direction - 90.0;
-            if (sprite->ghostEffect > 0)
-            {
-                Uint8 alpha = (Uint8)(255*(1.0f - sprite->ghostEffect)/100.0f);
-                SDL_SetTextureAlphaMod(costume.texture, alpha);
-            }
-            else
-            {
-                SDL_SetTextureAlphaMod(costume.texture, 255);
-            }
-            if (sprite->brightnessEffect > 0) {
-                Uint8 bright = (Uint8)(255 * (1.0f - sprite->brightnessEffect/100.0f));
-                SDL_SetTextureColorMod(costume.texture, bright,bright,bright);
-            }
-            else
-            {
-                SDL_SetTextureColorMod(costume.texture,255,255,255);
-            }
-            if (sprite->saturationEffect > 0)
-                Logger::info("Saturation effect: " + std::to_string(sprite->saturationEffect));
-            SDL_RenderCopyEx(state.renderer, costume.texture, nullptr, &dst,
-                angle, nullptr, SDL_FLIP_NONE);
-        }
+    int ox = state.stageWidth / 2, oy = state.stageHeight / 2;
+    for (size_t i = state.penStrokesDrawn; i < state.penStrokes.size(); i++)
+        drawStroke(r, state.penStrokes[i], 0, ox, oy);
+    state.penStrokesDrawn = state.penStrokes.size();
 
-        // Speech bubble
-        if (!sprite->sayText.empty() && (sprite->sayTimer > 0.0f || sprite->sayTimer == -1.0f)) {
-            int screenX = state.stageX + state.stageWidth / 2 + (int)sprite->x;
-            int screenY = state.stageY + state.stageHeight / 2 - (int)sprite->y;
+    if (state.isDrawingStroke) {
+        const PenStroke& live = state.currentStroke;
+        if (state.penLiveDrawn > live.points.size()) state.penLiveDrawn = 0;
+        drawStroke(r, live, state.penLiveDrawn, ox, oy);
+        state.penLiveDrawn = live.points.size();
+    }
+    flushPen(r);
+    SDL_SetRenderTarget(r, prev);
+    return true;
+}
+
+void renderPen(GameState& state) {
+    SDL_Rect stage = {state.stageX, state.stageY, state.stageWidth, state.stageHeight};
+    if (updatePenLayer(state)) {
+        SDL_RenderCopy(state.renderer, state.penLayer, nullptr, &stage);
+        return;
+    }
 
-            int bubbleX = screenX + 40;
-            int bubbleY = screenY - 50;
-            int bubbleW = 150;
-            int bubbleH = 40;
+    // No render targets: draw every stroke every frame
+    int ox = state.stageX + state.stageWidth / 2, oy = state.stageY + state.stageHeight / 2;
+    for (const PenStroke& stroke : state.penStrokes)
+        drawStroke(state.renderer, stroke, 0, ox, oy);
+    if (state.isDrawingStroke)
+        drawStroke(state.renderer, state.currentStroke, 0, ox, oy);
+    flushPen(state.renderer);
+}
 
-            SDL_SetRenderDrawColor(state.renderer, 255, 255, 255, 255);
-            SDL_Rect bubble = {bubbleX, bubbleY, bubbleW, bubbleH};
-            SDL_RenderFillRect(state.renderer, &bubble);
+// ─── Sprites ───────────────────────────────────────────────────────────────
+static void renderSprite(GameState& state, Sprite* sprite) {
+    const SpriteTable& st = state.spriteData;
+    const int id = sprite->id;
+    Costume& costume = sprite->costumes[sprite->currentCostume];
+
+    int screenX = state.stageX + state.stageWidth / 2 + (int)st.x[id];
+    int screenY = state.stageY + state.stageHeight / 2 - (int)st.y[id];
+
+    int w = (int)(costume.width * st.size[id] / 100.0f);
+    int h = (int)(costume.height * st.size[id] / 100.0f);
+
+    // Off-stage: the rotated costume stays within its half-diagonal
+    int reach = (int)std::ceil(std::sqrt((float)(w * w + h * h)) / 2);
+    if (screenX + reach < state.stageX || screenX - reach > state.stageX + state.stageWidth ||
+        screenY + reach < state.stageY || screenY - reach > state.stageY + state.stageHeight)
+        return;
+
+    SDL_Rect dst = {screenX - w/2, screenY - h/2, w, h};
+
+    double angle = st.direction[id] - 90.0;
+    Uint8 alpha = (Uint8)(255 * (1.0f - sprite->ghostEffect / 100.0f));
+    // Colour effects are baked into a cached texture; ghost stays a mod
+    SDL_Texture* tex = Effects::texture(state.renderer, costume, sprite->colorEffect,
+                                        sprite->brightnessEffect, sprite->saturationEffect);
+    SDL_SetTextureAlphaMod(tex, alpha);
+    SDL_SetTextureColorMod(tex, 255, 255, 255);
+    SDL_RenderCopyEx(state.renderer, tex, nullptr, &dst,
+        angle, nullptr, SDL_FLIP_NONE);
+}
 
-            SDL_SetRenderDrawColor(state.renderer, 0, 0, 0, 255);
-            SDL_RenderDrawRect(state.renderer, &bubble);
+static void renderBubble(GameState& state, Sprite* sprite) {
+    const SpriteTable& st = state.spriteData;
+    const int id = sprite->id;
+    int screenX = state.stageX + state.stageWidth / 2 + (int)st.x[id];
+    int screenY = state.stageY + state.stageHeight / 2 - (int)st.y[id];
 
-            if (true) {
-                renderText(state, sprite->sayText, bubbleX + 5, bubbleY + 10, {0, 0, 0, 255});
-            }
-        }
+    int bubbleX = screenX + 40;
+    int bubbleY = screenY - 50;
+    int bubbleW = 150;
+    int bubbleH = 40;
+
+    SDL_SetRenderDrawColor(state.renderer, 255, 255, 255, 255);
+    SDL_Rect bubble = {bubbleX, bubbleY, bubbleW, bubbleH};
+    SDL_RenderFillRect(state.renderer, &bubble);
+
+    SDL_SetRenderDrawColor(state.renderer, 0, 0, 0, 255);
+    SDL_RenderDrawRect(state.renderer, &bubble);
+
+    renderText(state, sprite->sayText, bubbleX + 5, bubbleY + 10, {0, 0, 0, 255});
+}
+
+// Every visible sprite back to front (SpriteTable::drawOrder), clipped to
+// the stage, then speech bubbles on top
+void renderSprites(GameState& state) {
+    const SpriteTable& st = state.spriteData;
+    SDL_Rect stage = {state.stageX, state.stageY, state.stageWidth, state.stageHeight};
+    SDL_RenderSetClipRect(state.renderer, &stage);
+    for (const auto& entry : st.drawOrder) {
+        Sprite* sprite = state.sprites[entry.second];
+        if (!st.visible[entry.second] || sprite->ghostEffect >= 100 || sprite->costumes.empty())
+            continue;
+        renderSprite(state, sprite);
     }
+    SDL_RenderSetClipRect(state.renderer, nullptr);
+
+    for (Sprite* sprite : state.sprites)
+        if (!sprite->sayText.empty() && (sprite->sayTimer > 0.0f || sprite->sayTimer == -1.0f))
+            renderBubble(state, sprite);
+}
+
+void renderStageContent(GameState& state) {
+    // Stage background (solid color)
+    SDL_SetRenderDrawColor(state.renderer,
+        state.stageColor.r, state.stageColor.g, state.stageColor.b, 255);
+    SDL_Rect stage = {state.stageX, state.stageY, state.stageWidth, state.stageHeight};
+    SDL_RenderFillRect(state.renderer, &stage);
+
+    renderPen(state);
+
+    renderSprites(state);
     renderVariableMonitor(state);
 }
 
@@ -238,7 +347,7 @@ void renderTopBar(GameState& state) {
     SDL_RenderDrawRect(state.renderer, &bgBtn);
 
     if (true) {
-        renderText(state, "Color", 15, 10, {0, 0, 0, 255});
+        renderLabel(state, "Color", 15, 10, {0, 0, 0, 255});
     }
 }
 
@@ -254,7 +363,7 @@ void renderPalette(GameState& state) {
 
     // Title
     if (true) {
-        renderText(state, "Block Palette", 10, 45, {0, 0, 0, 255});
+        renderLabel(state, "Block Palette", 10, 45, {0, 0, 0, 255});
     }
 
     // Render palette blocks
@@ -275,8 +384,8 @@ void renderEditor(GameState& state) {
 
     // Title
     if (true) {
-        renderText(state, "Code Editor", state.editorX + 10, 45, {0, 0, 0, 255});
-        renderText(state, "(Drag blocks here)", state.editorX + 10, 65, {128, 128, 128, 255});
+        renderLabel(state, "Code Editor", state.editorX + 10, 45, {0, 0, 0, 255});
+        renderLabel(state, "(Drag blocks here)", state.editorX + 10, 65, {128, 128, 128, 255});
     }
 
     // Render editor blocks (except dragged)
@@ -300,124 +409,9 @@ void renderStage(GameState& state) {
     SDL_Rect stage = {state.stageX, state.stageY, state.stageWidth, state.stageHeight};
     SDL_RenderFillRect(state.renderer, &stage);
 
-    // ═══════════════════════════════════════════════
-    // PEN DRAWING (FIXED!)
-    // ═══════════════════════════════════════════════
-
-    // Draw completed strokes
-    for (const PenStroke& stroke : state.penStrokes) {
-        if (stroke.points.size() < 2) continue;
-
-        SDL_SetRenderDrawColor(state.renderer,
-            stroke.color.r, stroke.color.g, stroke.color.b, stroke.color.a);
-
-        for (size_t i = 1; i < stroke.points.size(); i++) {
-            // Convert stage coordinates to screen coordinates
-            int x1 = state.stageX + state.stageWidth / 2 + stroke.points[i-1].x;
-            int y1 = state.stageY + state.stageHeight / 2 - stroke.points[i-1].y;
-            int x2 = state.stageX + state.stageWidth / 2 + stroke.points[i].x;
-            int y2 = state.stageY + state.stageHeight / 2 - stroke.points[i].y;
-
-            // Draw thick line
-            for (int t = -stroke.size/2; t <= stroke.size/2; t++) {
-                SDL_RenderDrawLine(state.renderer, x1 + t, y1, x2 + t, y2);
-                SDL_RenderDrawLine(state.renderer, x1, y1 + t, x2, y2 + t);
-            }
-        }
-    }
-
-    // Draw current stroke (being drawn)
-    if (state.isDrawingStroke && state.currentStroke.points.size() >= 2) {
-        SDL_SetRenderDrawColor(state.renderer,
-            state.currentStroke.color.r, state.currentStroke.color.g,
-            state.currentStroke.color.b, state.currentStroke.color.a);
-
-        for (size_t i = 1; i < state.currentStroke.points.size(); i++) {
-            int x1 = state.stageX + state.stageWidth / 2 + state.currentStroke.points[i-1].x;
-            int y1 = state.stageY + state.stageHeight / 2 - state.currentStroke.points[i-1].y;
-            int x2 = state.stageX + state.stageWidth / 2 + state.currentStroke.points[i].x;
-            int y2 = state.stageY + state.stageHeight / 2 - state.currentStroke.points[i].y;
-
-            for (int t = -state.currentStroke.size/2; t <= state.currentStroke.size/2; t++) {
-                SDL_RenderDrawLine(state.renderer, x1 + t, y1, x2 + t, y2);
-                SDL_RenderDrawLine(state.renderer, x1, y1 + t, x2, y2 + t);
-            }
-        }
-    }
-
-    // Render sprite
-    if (state.selectedSpriteIndex >= 0 &&
-        state.selectedSpriteIndex < (int)state.sprites.size()) {
-
-        Sprite* sprite = state.sprites[state.selectedSpriteIndex];
-
-        if (sprite->visible && !sprite->costumes.empty()) {
-            Costume& costume = sprite->costumes[sprite->currentCostume];
-
-            // Convert stage coords to screen coords
-            int screenX = state.stageX + state.stageWidth / 2 + (int)sprite->x;
-            int screenY = state.stageY + state.stageHeight / 2 - (int)sprite->y;
-
-            int w = (int)(costume.width * sprite->size / 100.0f);
-            int h = (int)(costume.height * sprite->size / 100.0f);
-
-            SDL_Rect dst = {screenX - w/2, screenY - h/2, w, h};
-
-            // Rotate sprite
-            double angle = sprite->direction - 90.0;
-            if (sprite->ghostEffect > 0)
-            {
-                Uint8 alpha = (Uint8)(255*(1.0f - sprite->ghostEffect)/100.0f);
-                SDL_SetTextureAlphaMod(costume.texture, alpha);
-            }
-            else
-            {
-                SDL_SetTextureAlphaMod(costume.texture, 255);
-            }
-            if (sprite->ghostEffect > 0) {
-                Uint8 alpha = (Uint8)(255 * (1.0f - sprite->ghostEffect/100.0f));
-                SDL_SetTextureAlphaMod(costume.texture, alpha);
-            } else {
-                SDL_SetTextureAlphaMod(costume.texture, 255);
-            }
-            if (sprite->brightnessEffect > 0) {
-                Uint8 bright = (Uint8)(255 * (1.0f - sprite->brightnessEffect/100.0f));
-                SDL_SetTextureAlphaMod(costume.texture, bright);
-            }
-            else
-            {
-                SDL_SetTextureAlphaMod(costume.texture,255);
-            }
-
-            SDL_RenderCopyEx(state.renderer, costume.texture, nullptr, &dst,
-                angle, nullptr, SDL_FLIP_NONE);
-        }
+    renderPen(state);
 
-        // Speech bubble
-        if (!sprite->sayText.empty() && sprite->sayTimer > 0.0f) {
-            int screenX = state.stageX + state.stageWidth / 2 + (int)sprite->x;
-            int screenY = state.stageY + state.stageHeight / 2 - (int)sprite->y;
-
-            int bubbleX = screenX + 40;
-            int bubbleY = screenY - 50;
-            int bubbleW = 150;
-            int bubbleH = 40;
-
-            // Bubble background
-            SDL_SetRenderDrawColor(state.renderer, 255, 255, 255, 255);
-            SDL_Rect bubble = {bubbleX, bubbleY, bubbleW, bubbleH};
-            SDL_RenderFillRect(state.renderer, &bubble);
-
-            // Bubble border
-            SDL_SetRenderDrawColor(state.renderer, 0, 0, 0, 255);
-            SDL_RenderDrawRect(state.renderer, &bubble);
-
-            // Text
-            if (true) {
-                renderText(state, sprite->sayText, bubbleX + 5, bubbleY + 10, {0, 0, 0, 255});
-            }
-        }
-    }
+    renderSprites(state);
 }
 
 void renderBlock(GameState& state, Block* block, bool ghost) {
@@ -441,78 +435,17 @@ void renderBlock(GameState& state, Block* block, bool ghost) {
 
     // Text
     if (true) {
-        renderText(state, block->text, block->x + 8, block->y + 10, {255, 255, 255, 255});
+        renderLabel(state, block->text, block->x + 8, block->y + 10, {255, 255, 255, 255});
     }
 }
 
 void renderText(GameState& state, const std::string& text, int x, int y, SDL_Color color) {
-    // Pixel font - 5x7 glyphs, same table as UIManager
-    static const unsigned char F[95][7]={
-    {0,0,0,0,0,0,0},{0x04,0x04,0x04,0x04,0,0x04,0},{0x0A,0x0A,0,0,0,0,0},
-    {0x0A,0x1F,0x0A,0x0A,0x1F,0x0A,0},{0x04,0x0F,0x14,0x0E,0x05,0x1E,0x04},
-    {0,0,0,0,0,0,0},{0,0,0,0,0,0,0},{0x04,0x04,0,0,0,0,0},
-    {0x02,0x04,0x08,0x08,0x08,0x04,0x02},{0x08,0x04,0x02,0x02,0x02,0x04,0x08},
-    {0,0x04,0x15,0x0E,0x15,0x04,0},{0,0x04,0x04,0x1F,0x04,0x04,0},
-    {0,0,0,0,0x04,0x04,0x08},{0,0,0,0x1F,0,0,0},{0,0,0,0,0,0x04,0},
-    {0x01,0x01,0x02,0x04,0x08,0x10,0x10},
-    {0x0E,0x11,0x13,0x15,0x19,0x11,0x0E},{0x04,0x0C,0x04,0x04,0x04,0x04,0x0E},
-    {0x0E,0x11,0x01,0x06,0x08,0x10,0x1F},{0x1F,0x01,0x02,0x06,0x01,0x11,0x0E},
-    {0x02,0x06,0x0A,0x12,0x1F,0x02,0x02},{0x1F,0x10,0x1E,0x01,0x01,0x11,0x0E},
-    {0x06,0x08,0x10,0x1E,0x11,0x11,0x0E},{0x1F,0x01,0x02,0x04,0x08,0x08,0x08},
-    {0x0E,0x11,0x11,0x0E,0x11,0x11,0x0E},{0x0E,0x11,0x11,0x0F,0x01,0x02,0x0C},
-    {0,0x04,0,0,0x04,0,0},{0,0x04,0,0,0x04,0x04,0x08},
-    {0x02,0x04,0x08,0x10,0x08,0x04,0x02},{0,0,0x1F,0,0x1F,0,0},
-    {0x08,0x04,0x02,0x01,0x02,0x04,0x08},{0x0E,0x11,0x01,0x02,0x04,0,0x04},
-    {0x0E,0x11,0x17,0x15,0x17,0x10,0x0E},
-    {0x0E,0x11,0x11,0x1F,0x11,0x11,0x11},{0x1E,0x11,0x11,0x1E,0x11,0x11,0x1E},
-    {0x0E,0x11,0x10,0x10,0x10,0x11,0x0E},{0x1C,0x12,0x11,0x11,0x11,0x12,0x1C},
-    {0x1F,0x10,0x10,0x1E,0x10,0x10,0x1F},{0x1F,0x10,0x10,0x1E,0x10,0x10,0x10},
-    {0x0E,0x11,0x10,0x17,0x11,0x11,0x0F},{0x11,0x11,0x11,0x1F,0x11,0x11,0x11},
-    {0x0E,0x04,0x04,0x04,0x04,0x04,0x0E},{0x07,0x02,0x02,0x02,0x02,0x12,0x0C},
-    {0x11,0x12,0x14,0x18,0x14,0x12,0x11},{0x10,0x10,0x10,0x10,0x10,0x10,0x1F},
-    {0x11,0x1B,0x15,0x15,0x11,0x11,0x11},{0x11,0x19,0x15,0x13,0x11,0x11,0x11},
-    {0x0E,0x11,0x11,0x11,0x11,0x11,0x0E},{0x1E,0x11,0x11,0x1E,0x10,0x10,0x10},
-    {0x0E,0x11,0x11,0x11,0x15,0x12,0x0D},{0x1E,0x11,0x11,0x1E,0x14,0x12,0x11},
-    {0x0F,0x10,0x10,0x0E,0x01,0x01,0x1E},{0x1F,0x04,0x04,0x04,0x04,0x04,0x04},
-    {0x11,0x11,0x11,0x11,0x11,0x11,0x0E},{0x11,0x11,0x11,0x11,0x11,0x0A,0x04},
-    {0x11,0x11,0x15,0x15,0x15,0x15,0x0A},{0x11,0x11,0x0A,0x04,0x0A,0x11,0x11},
-    {0x11,0x11,0x0A,0x04,0x04,0x04,0x04},{0x1F,0x01,0x02,0x04,0x08,0x10,0x1F},
-    {0x0E,0x08,0x08,0x08,0x08,0x08,0x0E},{0x10,0x10,0x08,0x04,0x02,0x01,0x01},
-    {0x0E,0x02,0x02,0x02,0x02,0x02,0x0E},{0x04,0x0A,0x11,0,0,0,0},
-    {0,0,0,0,0,0,0x1F},{0x08,0x04,0,0,0,0,0},
-    {0,0,0x0E,0x01,0x0F,0x11,0x0F},{0x10,0x10,0x1E,0x11,0x11,0x11,0x1E},
-    {0,0,0x0E,0x10,0x10,0x10,0x0E},{0x01,0x01,0x0F,0x11,0x11,0x11,0x0F},
-    {0,0,0x0E,0x11,0x1F,0x10,0x0E},{0x06,0x09,0x08,0x1C,0x08,0x08,0x08},
-    {0,0,0x0F,0x11,0x0F,0x01,0x0E},{0x10,0x10,0x16,0x19,0x11,0x11,0x11},
-    {0x04,0,0x0C,0x04,0x04,0x04,0x0E},{0x02,0,0x06,0x02,0x02,0x12,0x0C},
-    {0x10,0x10,0x12,0x14,0x18,0x14,0x12},{0x0C,0x04,0x04,0x04,0x04,0x04,0x0E},
-    {0,0,0x1A,0x15,0x15,0x11,0x11},{0,0,0x16,0x19,0x11,0x11,0x11},
-    {0,0,0x0E,0x11,0x11,0x11,0x0E},{0,0,0x1E,0x11,0x1E,0x10,0x10},
-    {0,0,0x0F,0x11,0x0F,0x01,0x01},{0,0,0x16,0x19,0x10,0x10,0x10},
-    {0,0,0x0E,0x10,0x0E,0x01,0x1E},{0x08,0x08,0x1C,0x08,0x08,0x09,0x06},
-    {0,0,0x11,0x11,0x11,0x13,0x0D},{0,0,0x11,0x11,0x11,0x0A,0x04},
-    {0,0,0x11,0x15,0x15,0x15,0x0A},{0,0,0x11,0x0A,0x04,0x0A,0x11},
-    {0,0,0x11,0x11,0x0F,0x01,0x0E},{0,0,0x1F,0x02,0x04,0x08,0x1F},
-    {0x06,0x08,0x08,0x18,0x08,0x08,0x06},{0x04,0x04,0x04,0,0x04,0x04,0x04},
-    {0x0C,0x02,0x02,0x03,0x02,0x02,0x0C},{0x08,0x15,0x02,0,0,0,0}
-    };
-    SDL_SetRenderDrawColor(state.renderer, color.r, color.g, color.b, color.a);
-    int cx = x;
-    for (char ch : text) {
-        if (ch == ' ') { cx += 4; continue; }
-        int idx = (unsigned char)ch - 32;
-        if (idx < 0 || idx >= 95) { cx += 6; continue; }
-        for (int row = 0; row < 7; row++) {
-            unsigned char bits = F[idx][row];
-            for (int col = 0; col < 5; col++) {
-                if (bits & (0x10 >> col)) {
-                    SDL_Rect px = {cx+col, y+row, 1, 1};
-                    SDL_RenderFillRect(state.renderer, &px);
-                }
-            }
-        }
-        cx += 6;
-    }
+    Font::drawText(state.renderer, text, x, y, color);
+}
+
+// Text that repeats frame to frame (titles, block labels): cached run
+void renderLabel(GameState& state, const std::string& text, int x, int y, SDL_Color color) {
+    Font::drawLabel(state.renderer, text, x, y, color);
 }
 
 // ─── Ask/Answer overlay ────────────────────────────────────────────────────
@@ -561,18 +494,52 @@ void renderVariableMonitor(GameState& state) {
     if (state.variables.empty()) return;
     int vy = state.stageY + state.stageHeight + 10;
     int vx = state.stageX;
-    for (auto& kv : state.variables) {
-        if (state.variableVisible.count(kv.first) &&
-            !state.variableVisible.at(kv.first)) continue;
+    const VariableTable& vars = state.variables;
+    for (int i = 0; i < vars.size(); i++) {
+        if (!vars.visible[i]) continue;
 
         SDL_SetRenderDrawColor(state.renderer, 200, 100, 30, 220);
         SDL_Rect r = {vx, vy, 160, 20};
         SDL_RenderFillRect(state.renderer, &r);
-        renderText(state, kv.first + ": " + kv.second, vx + 4, vy + 6, {255,255,255,255});
+        renderText(state, vars.names[i] + ": " + toString(vars.values[i]),
+                   vx + 4, vy + 6, {255,255,255,255});
         vy += 24;
     }
 }
 
+// ─── Frame timing overlay ─────────────────────────────────────────────────
+void renderFrameStats(GameState& state) {
+    int x = state.stageX + 4, y = state.stageY + 4;
+    SDL_SetRenderDrawColor(state.renderer, 0, 0, 0, 180);
+    SDL_Rect bg = {x, y, 226, 14 + 12 * FrameStats::PH_Count};
+    SDL_RenderFillRect(state.renderer, &bg);
+
+    renderText(state, "ms       p50    p95    p99", x + 4, y + 4, {170, 170, 170, 255});
+    for (int p = 0; p < FrameStats::PH_Count; p++) {
+        FrameStats::Percentiles q = FrameStats::percentiles((FrameStats::Phase)p);
+        char line[64];
+        snprintf(line, sizeof line, "%-8s%6.2f %6.2f %6.2f",
+                 FrameStats::phaseName((FrameStats::Phase)p), q.p50, q.p95, q.p99);
+        SDL_Color col = q.p99 > 1000.0 / 60 ? SDL_Color{255, 120, 80, 255}  // over a 60 Hz frame
+                                           : SDL_Color{255, 255, 255, 255};
+        renderText(state, line, x + 4, y + 16 + 12 * p, col);
+    }
+}
+
+// ─── Memory report overlay ────────────────────────────────────────────────
+void renderMemStats(GameState& state) {
+    std::vector<std::string> lines = MemStats::describe(MemStats::snapshot(state));
+    int w = 214, h = 16 + 12 * (int)lines.size();
+    int x = state.stageX + state.stageWidth - w - 4, y = state.stageY + 4;
+    SDL_SetRenderDrawColor(state.renderer, 0, 0, 0, 180);
+    SDL_Rect bg = {x, y, w, h};
+    SDL_RenderFillRect(state.renderer, &bg);
+
+    renderText(state, "memory           size   count", x + 4, y + 4, {170, 170, 170, 255});
+    for (int i = 0; i < (int)lines.size(); i++)
+        renderText(state, lines[i], x + 4, y + 16 + 12 * i, {255, 255, 255, 255});
+}
+
 // ─── Snap preview highlight ────────────────────────────────────────────────
 void renderSnapPreview(GameState& state) {
     if (!state.snapTarget || !state.draggedBlock) return;
@@ -594,12 +561,11 @@ void renderExecutionCursor(GameState& state) {
         state.selectedSpriteIndex >= (int)state.sprites.size()) return;
 
     Sprite* sp = state.sprites[state.selectedSpriteIndex];
-    auto it = state.exec.ctx.find(sp);
-    if (it == state.exec.ctx.end()) return;
-    int pc = it->second.pc;
+    if (sp->id >= (int)state.exec.ctx.size() || state.exec.ctx[sp->id].empty()) return;
+    int pc = state.exec.ctx[sp->id].front().pc; // oldest live thread of the sprite
 
-    if (pc >= 0 && pc < (int)state.editorBlocks.size()) {
-        Block* cur = state.editorBlocks[pc];
+    if (pc >= 0 && pc < (int)state.program.code.size()) {
+        const Block* cur = state.program.code[pc].src;
         SDL_SetRenderDrawBlendMode(state.renderer, SDL_BLENDMODE_BLEND);
         SDL_SetRenderDrawColor(state.renderer, 255, 255, 0, 200);
         SDL_Rect cursor = {cur->x - 4, cur->y - 4, cur->width + 8, cur->height + 8};
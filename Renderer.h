@@ -6,6 +6,8 @@ namespace Renderer {
     void renderPaletteBlocks  (GameState& state);
     void renderEditorBlocks   (GameState& state);
     void renderStageContent   (GameState& state);
+    void renderPen            (GameState& state);
+    void renderSprites        (GameState& state);
     void renderTopBar         (GameState& state);
     void renderPalette        (GameState& state);
     void renderEditor         (GameState& state);
@@ -15,8 +17,12 @@ namespace Renderer {
     void renderVariableMonitor(GameState& state);
     void renderSnapPreview    (GameState& state);
     void renderExecutionCursor(GameState& state);
+    void renderFrameStats     (GameState& state);
+    void renderMemStats       (GameState& state);
 
     SDL_Color getCategoryColor(BlockCategory cat);
     void renderText(GameState& state, const std::string& text,
                     int x, int y, SDL_Color color);
+    void renderLabel(GameState& state, const std::string& text,
+                     int x, int y, SDL_Color color);
 }
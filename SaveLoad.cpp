@@ -1,8 +1,11 @@
 #include "SaveLoad.h"
 #include "Logger.h"
+#include "Timeline.h"
+#include "Compiler.h"
 #include <fstream>
 #include <sstream>
 #include <map>
+#include <cstdio>
 
 namespace SaveLoad {
 
@@ -35,6 +38,11 @@ static const std::map<BlockType, std::string>& typeToStr() {
         {BLOCK_PlaySound,     "playSound"},
         {BLOCK_StopAllSounds, "stopAllSounds"},
         {BLOCK_WhenFlagClicked,"whenFlagClicked"},
+        {BLOCK_WhenKeyPressed,"whenKeyPressed"},
+        {BLOCK_WhenSpriteClicked,"whenSpriteClicked"},
+        {BLOCK_WhenReceive,   "whenReceive"},
+        {BLOCK_Broadcast,     "broadcast"},
+        {BLOCK_BroadcastAndWait,"broadcastAndWait"},
         {BLOCK_Wait,          "wait"},
         {BLOCK_WaitUntil,     "waitUntil"},
         {BLOCK_Repeat,        "repeat"},
@@ -76,11 +84,24 @@ static BlockType strToType(const std::string& s) {
     return BLOCK_None;
 }
 
+std::string typeName(BlockType type) {
+    switch (type) { // compiler-only control ops, never saved
+        case OP_Jump:     return "jump";
+        case OP_LoopNext: return "loopNext";
+        case OP_LoopBack: return "loopBack";
+        case OP_Halt:     return "halt";
+        default:          break;
+    }
+    auto it = typeToStr().find(type);
+    return it != typeToStr().end() ? it->second : "";
+}
+
 static int catToInt(BlockCategory c) { return (int)c; }
 static BlockCategory intToCat(int i) { return (BlockCategory)i; }
 
 // ─── serialization helpers ────────────────────────────────────────────────
-static void writeBlock(std::ofstream& f, const Block* b, int indent = 0) {
+// `next` is the index of b->nextBlock among the top-level blocks, -1 for none
+static void writeBlock(std::ofstream& f, const Block* b, int indent = 0, int next = -1) {
     std::string sp(indent * 2, ' ');
     auto it = typeToStr().find(b->type);
     std::string ts = (it != typeToStr().end()) ? it->second : "none";
@@ -91,6 +112,7 @@ static void writeBlock(std::ofstream& f, const Block* b, int indent = 0) {
     f << sp << "  num " << b->numberValue << "\n";
     f << sp << "  str " << b->stringValue << "\n";
     f << sp << "  xy " << b->x << " " << b->y << "\n";
+    if (next >= 0) f << sp << "  next " << next << "\n";
 
     if (!b->nested.empty()) {
         f << sp << "  NESTED " << b->nested.size() << "\n";
@@ -107,13 +129,14 @@ static void writeBlock(std::ofstream& f, const Block* b, int indent = 0) {
 
 // ─── save ────────────────────────────────────────────────────────────────────
 bool saveProject(const GameState& state, const std::string& filename) {
+    Timeline::Span span("io", "save");
     std::ofstream f(filename);
     if (!f.is_open()) {
-        Logger::error("Cannot open file for save: " + filename);
+        LOG_ERROR(IO, "Cannot open file for save: " + filename);
         return false;
     }
 
-    f << "# ScratchClone Project v2\n";
+    f << "# ScratchClone Project v4\n";
 
     // Stage
     f << "[stage]\n";
@@ -126,8 +149,9 @@ bool saveProject(const GameState& state, const std::string& filename) {
     // Variables
     f << "[variables]\n";
     f << "count " << state.variables.size() << "\n";
-    for (auto& kv : state.variables)
-        f << "var " << kv.first << " " << kv.second << "\n";
+    for (int i = 0; i < state.variables.size(); i++)
+        f << "var " << state.variables.names[i] << " "
+          << toString(state.variables.values[i]) << "\n";
 
     // Sprites
     f << "[sprites]\n";
@@ -135,28 +159,31 @@ bool saveProject(const GameState& state, const std::string& filename) {
     for (auto* sp : state.sprites) {
         f << "SPRITE\n";
         f << "  name " << sp->name << "\n";
-        f << "  pos "  << sp->x << " " << sp->y << "\n";
-        f << "  dir "  << sp->direction << "\n";
-        f << "  size " << sp->size << "\n";
-        f << "  vis "  << (sp->visible ? 1 : 0) << "\n";
+        const SpriteTable& st = state.spriteData;
+        f << "  pos "  << st.x[sp->id] << " " << st.y[sp->id] << "\n";
+        f << "  dir "  << st.direction[sp->id] << "\n";
+        f << "  size " << st.size[sp->id] << "\n";
+        f << "  vis "  << (st.visible[sp->id] ? 1 : 0) << "\n";
         f << "  cost " << sp->currentCostume << "\n";
+        const std::vector<Block*>& blocks = state.scriptsOf(sp);
+        f << "  scripts " << blocks.size() << "\n";
+        std::map<const Block*, int> index;
+        for (size_t i = 0; i < blocks.size(); i++) index[blocks[i]] = (int)i;
+        for (auto* b : blocks) {
+            auto next = index.find(b->nextBlock);
+            writeBlock(f, b, 1, next != index.end() ? next->second : -1);
+        }
         f << "END_SPRITE\n";
     }
 
-    // Editor blocks
-    f << "[blocks]\n";
-    f << "count " << state.editorBlocks.size() << "\n";
-    for (auto* b : state.editorBlocks)
-        writeBlock(f, b);
-
     f.close();
-    Logger::info("Project saved to: " + filename);
+    LOG_INFO(IO, "Project saved to: " + filename);
     return true;
 }
 
 // ─── load ────────────────────────────────────────────────────────────────────
-// Simple line-based parser
-static Block* parseBlock(std::ifstream& f) {
+// Simple line-based parser; `next` receives the block's saved next index
+static Block* parseBlock(std::ifstream& f, int* next = nullptr) {
     Block* b = new Block();
     std::string line;
     while (std::getline(f, line)) {
@@ -176,6 +203,7 @@ static Block* parseBlock(std::ifstream& f) {
         else if (token == "num")  { ss >> b->numberValue; }
         else if (token == "str")  { std::string v; std::getline(ss, v); if (!v.empty() && v[0]==' ') v=v.substr(1); b->stringValue=v; }
         else if (token == "xy")   { ss >> b->x >> b->y; }
+        else if (token == "next") { if (next) ss >> *next; }
         else if (token == "NESTED") {
             int cnt; ss >> cnt;
             for (int i = 0; i < cnt; i++) {
@@ -218,24 +246,44 @@ static Block* parseBlock(std::ifstream& f) {
     return b;
 }
 
+// Restore nextBlock for blocks[first..] from their saved indices. Files
+// before v3 have none: those ran top-level blocks in list order, so each
+// block chains to the one after it unless that one starts a script.
+static void linkBlocks(std::vector<Block*>& blocks, size_t first,
+                       const std::vector<int>& next, int version) {
+    for (size_t i = first; i < blocks.size(); i++) {
+        if (version < 3) {
+            if (i + 1 < blocks.size() && !Compiler::isHat(blocks[i + 1]->type))
+                blocks[i]->nextBlock = blocks[i + 1];
+            continue;
+        }
+        int n = next[i - first];
+        if (n >= 0 && first + n < blocks.size() && first + n != i)
+            blocks[i]->nextBlock = blocks[first + n];
+    }
+}
+
 bool loadProject(GameState& state, const std::string& filename) {
+    Timeline::Span span("io", "load");
     std::ifstream f(filename);
     if (!f.is_open()) {
-        Logger::error("Cannot open file for load: " + filename);
+        LOG_ERROR(IO, "Cannot open file for load: " + filename);
         return false;
     }
 
     // Clear existing state
-    for (auto* b : state.editorBlocks) delete b;
-    state.editorBlocks.clear();
-    state.penStrokes.clear();
-    state.isDrawingStroke = false;
+    state.clearScripts();
+    state.exec.running = false;
+    state.clearPen();
 
     std::string line;
     std::string section;
+    int version = 0;
+    std::vector<int> editorNext; // saved next index per [blocks] entry
 
     while (std::getline(f, line)) {
-        if (line.empty() || line[0] == '#') continue;
+        if (line.empty()) continue;
+        if (line[0] == '#') { sscanf(line.c_str(), "# ScratchClone Project v%d", &version); continue; }
         if (line[0] == '[') { section = line; continue; }
 
         std::istringstream ss(line);
@@ -254,13 +302,16 @@ bool loadProject(GameState& state, const std::string& filename) {
                 std::string name, val;
                 ss >> name; std::getline(ss, val);
                 if (!val.empty() && val[0]==' ') val=val.substr(1);
-                state.variables[name] = val;
+                state.variables.set(name, parseValue(val));
             }
         }
         else if (section == "[sprites]") {
             if (token == "SPRITE") {
                 // Parse sprite block
                 Sprite* sp = nullptr;
+                SpriteTable& st = state.spriteData;
+                size_t first = 0;
+                std::vector<int> next;
                 // Find existing or create
                 while (std::getline(f, line)) {
                     if (line.empty()) continue;
@@ -272,29 +323,44 @@ bool loadProject(GameState& state, const std::string& filename) {
                         sp = nullptr;
                         for (auto* s : state.sprites)
                             if (s->name == nm) { sp = s; break; }
-                        if (!sp) { sp = new Sprite(); sp->name = nm; state.sprites.push_back(sp); }
+                        if (!sp) { sp = new Sprite(); sp->name = nm; state.addSprite(sp); }
+                        first = state.scriptsOf(sp).size();
+                        next.clear();
                     }
-                    else if (t2 == "pos"  && sp) { ss2 >> sp->x >> sp->y; }
-                    else if (t2 == "dir"  && sp) { ss2 >> sp->direction; }
-                    else if (t2 == "size" && sp) { ss2 >> sp->size; }
-                    else if (t2 == "vis"  && sp) { int v; ss2 >> v; sp->visible=(v==1); }
+                    else if (t2 == "pos"  && sp) { ss2 >> st.x[sp->id] >> st.y[sp->id]; }
+                    else if (t2 == "dir"  && sp) { ss2 >> st.direction[sp->id]; }
+                    else if (t2 == "size" && sp) { ss2 >> st.size[sp->id]; }
+                    else if (t2 == "vis"  && sp) { int v; ss2 >> v; st.visible[sp->id]=(v==1); }
                     else if (t2 == "cost" && sp) { ss2 >> sp->currentCostume; }
+                    else if (t2 == "BLOCK" && sp) {
+                        std::string ts; ss2 >> ts;
+                        next.push_back(-1);
+                        Block* b = parseBlock(f, &next.back());
+                        b->type = strToType(ts);
+                        state.scriptsOf(sp).push_back(b);
+                    }
                     else if (t2 == "END_SPRITE") break;
                 }
+                if (sp) linkBlocks(state.scriptsOf(sp), first, next, version);
             }
         }
         else if (section == "[blocks]") {
+            // v2/v3 files: one shared workspace, given to the selected sprite
             if (token == "BLOCK") {
                 std::string ts; ss >> ts;
-                Block* b = parseBlock(f);
+                editorNext.push_back(-1);
+                Block* b = parseBlock(f, &editorNext.back());
                 b->type = strToType(ts);
                 state.editorBlocks.push_back(b);
             }
         }
     }
 
+    if (!editorNext.empty())
+        linkBlocks(state.editorBlocks, state.editorBlocks.size() - editorNext.size(), editorNext, version);
+
     f.close();
-    Logger::info("Project loaded from: " + filename);
+    LOG_INFO(IO, "Project loaded from: " + filename);
     return true;
 }
 
@@ -6,4 +6,5 @@ namespace SaveLoad {
     bool        saveProject     (const GameState& state, const std::string& filename);
     bool        loadProject     (GameState& state,       const std::string& filename);
     std::string getDefaultSavePath();
+    std::string typeName(BlockType type); // save-format / control-op name, "" if none
 }
@@ -269,14 +269,13 @@ SDL_Surface* createArrow(int size) {
 void generateAllSprites(SDL_Renderer* renderer) {
     // Ensure assets directory exists before saving PNGs
     mkdir("assets", 0755);
-    Logger::info("Generating sprite assets...");
+    LOG_INFO(IO, "Generating sprite assets...");
     // We store generated textures in a global map so loadAssets can retrieve them
     // Nothing to do here – textures are generated on-demand via createTextureFor()
     (void)renderer;
 }
 
-// Create a SDL_Texture directly from a generated surface (used by loadAssets)
-SDL_Texture* createTextureFor(SDL_Renderer* renderer, const std::string& shape) {
+SDL_Surface* createSurfaceFor(const std::string& shape) {
     const int SIZE = 80;
     SDL_Surface* surface = nullptr;
 
@@ -289,7 +288,12 @@ SDL_Texture* createTextureFor(SDL_Renderer* renderer, const std::string& shape)
     else if (shape == "diamond")  surface = createDiamond(SIZE);
     else if (shape == "arrow")    surface = createArrow(SIZE);
     else                          surface = createCircle(SIZE);  // default
+    return surface;
+}
 
+// Create a SDL_Texture directly from a generated surface (used by loadAssets)
+SDL_Texture* createTextureFor(SDL_Renderer* renderer, const std::string& shape) {
+    SDL_Surface* surface = createSurfaceFor(shape);
     if (!surface) return nullptr;
     SDL_Texture* tex = SDL_CreateTextureFromSurface(renderer, surface);
     SDL_FreeSurface(surface);
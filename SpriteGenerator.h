@@ -8,6 +8,8 @@ namespace SpriteGen {
 
     // Create a GPU texture for a named shape (circle/square/triangle/star/…)
     SDL_Texture* createTextureFor(SDL_Renderer* renderer, const std::string& shape);
+    // The generated surface itself; caller frees it
+    SDL_Surface* createSurfaceFor(const std::string& shape);
 
     // Individual sprite generators
     SDL_Surface* createCircle(int size);
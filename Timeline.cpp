@@ -0,0 +1,123 @@
+#include "Timeline.h"
+#include "Logger.h"
+#include <atomic>
+#include <cstring>
+#include <fstream>
+
+namespace Timeline {
+    bool  recording     = false;
+    float windowSeconds = 10;
+    float slowFrameMs   = 100;
+
+    static const int CAPACITY = 1 << 15; // events; older ones are overwritten
+    static const int NAME_MAX = 32;
+
+    struct Event {
+        Uint64      start, end;
+        const char* category;
+        int         tid;
+        char        name[NAME_MAX];
+    };
+
+    static Event                 ring[CAPACITY];
+    static std::atomic<uint64_t> written(0);
+    static std::atomic<int>      nextTid(0);
+    static thread_local int      tid = nextTid++; // per recording thread, in first-use order
+
+    static Uint64 lastAutoCapture = 0;
+    static int    captures = 0;
+
+    void record(const char* category, const char* name, Uint64 start, Uint64 end) {
+        Event& e = ring[written.fetch_add(1, std::memory_order_relaxed) % CAPACITY];
+        e.start    = start;
+        e.end      = end;
+        e.category = category;
+        e.tid      = tid;
+        strncpy(e.name, name, NAME_MAX - 1);
+        e.name[NAME_MAX - 1] = '\0';
+    }
+
+    Span::Span(const char* category, const char* name)
+        : category(category), name(name), start(recording ? SDL_GetPerformanceCounter() : 0) {}
+
+    Span::Span(const char* category, const std::string& name)
+        : category(category), name(nullptr), start(0) {
+        if (!recording) return;
+        owned = name;
+        start = SDL_GetPerformanceCounter();
+    }
+
+    Span::~Span() {
+        if (start && recording)
+            record(category, name ? name : owned.c_str(), start, SDL_GetPerformanceCounter());
+    }
+
+    static void writeEscaped(std::ofstream& f, const char* s) {
+        for (; *s; s++) {
+            if (*s == '"' || *s == '\\') f << '\\';
+            if ((unsigned char)*s >= 0x20) f << *s;
+        }
+    }
+
+    // Call between ticks: worker threads must not be recording meanwhile
+    bool capture(const std::string& filename) {
+        std::ofstream f(filename);
+        if (!f.is_open()) {
+            LOG_ERROR(IO, "Cannot open file for timeline: " + filename);
+            return false;
+        }
+
+        const double usPerTick = 1e6 / SDL_GetPerformanceFrequency();
+        Uint64 now    = SDL_GetPerformanceCounter();
+        Uint64 window = (Uint64)(windowSeconds * SDL_GetPerformanceFrequency());
+        Uint64 from   = now > window ? now - window : 0;
+
+        uint64_t total = written.load();
+        uint64_t first = total > (uint64_t)CAPACITY ? total - CAPACITY : 0;
+
+        f << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        // Captures run on the main loop, so the calling thread is "main"
+        int threads = nextTid.load(), self = tid, worker = 0;
+        for (int t = 0; t < threads; t++) {
+            f << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t
+              << ",\"args\":{\"name\":\"" << (t == self ? "main" : "worker " + std::to_string(++worker))
+              << "\"}},\n";
+        }
+        int events = 0;
+        for (uint64_t n = first; n < total; n++) {
+            const Event& e = ring[n % CAPACITY];
+            if (e.start < from) continue;
+            f << "{\"name\":\"";
+            writeEscaped(f, e.name);
+            f << "\",\"cat\":\"" << e.category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.tid
+              << ",\"ts\":" << (long long)(e.start * usPerTick)
+              << ",\"dur\":" << (long long)((e.end - e.start) * usPerTick) << "},\n";
+            events++;
+        }
+        // Trailing entry keeps the array valid JSON without tracking commas
+        f << "{\"name\":\"capture\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":" << self << ",\"ts\":"
+          << (long long)(now * usPerTick) << "}\n]}\n";
+
+        LOG_INFO(IO, "Timeline (" + std::to_string(events) + " events) written to: " + filename);
+        return true;
+    }
+
+    bool capture() {
+        return capture("timeline-" + std::to_string(++captures) + ".json");
+    }
+
+    void frameDone(Uint64 start, Uint64 end) {
+        if (!recording) return;
+        record("frame", "frame", start, end);
+
+        double ms = (end - start) * 1000.0 / SDL_GetPerformanceFrequency();
+        if (slowFrameMs <= 0 || ms < slowFrameMs) return;
+
+        // One capture per window, so a run of slow frames doesn't write a file each
+        Uint64 cooldown = (Uint64)(windowSeconds * SDL_GetPerformanceFrequency());
+        if (lastAutoCapture && end - lastAutoCapture < cooldown) return;
+        lastAutoCapture = end;
+        Logger::warning("Slow frame (" + std::to_string(ms) + " ms), capturing timeline");
+        capture();
+    }
+}
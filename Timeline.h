@@ -0,0 +1,31 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <string>
+
+// Timeline of frames, engine phases, script slices and save/load, kept in
+// a ring and written as Chrome trace-event JSON (chrome://tracing,
+// Perfetto) covering the last `windowSeconds`. A capture is taken on
+// request (F9) or automatically after a frame slower than `slowFrameMs`.
+namespace Timeline {
+    extern bool  recording;     // F8
+    extern float windowSeconds; // how far back a capture reaches
+    extern float slowFrameMs;   // auto-capture threshold, 0 = off
+
+    // A finished span [start, end) in performance-counter ticks
+    void record(const char* category, const char* name, Uint64 start, Uint64 end);
+
+    // RAII span; costs one branch while not recording
+    struct Span {
+        Span(const char* category, const char* name);
+        Span(const char* category, const std::string& name);
+        ~Span();
+        const char* category;
+        const char* name;
+        std::string owned; // copy for names that may not outlive the span
+        Uint64      start;
+    };
+
+    bool capture(const std::string& filename);
+    bool capture();                             // timeline-N.json
+    void frameDone(Uint64 start, Uint64 end);   // frame span + slow-frame trigger
+}
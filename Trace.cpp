@@ -0,0 +1,126 @@
+#include "Trace.h"
+#include "Logger.h"
+#include <atomic>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+
+namespace Trace {
+    Header* header = nullptr;
+
+    static Record*  records  = nullptr;
+    static size_t   fileSize = 0;
+    static std::atomic<uint64_t>* written = nullptr; // header->written, shared by all producers
+
+    static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) &&
+                  std::atomic<uint64_t>::is_always_lock_free,
+                  "claim counter is updated in place inside the mapping");
+
+#ifndef _WIN32
+    static int fd = -1;
+
+    static void* mapFile(const std::string& path, size_t size) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return nullptr;
+        if (ftruncate(fd, (off_t)size) != 0) { ::close(fd); fd = -1; return nullptr; }
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) { ::close(fd); fd = -1; return nullptr; }
+        return p;
+    }
+
+    static void unmapFile(void* p, size_t size) {
+        msync(p, size, MS_SYNC);
+        munmap(p, size);
+        ::close(fd);
+        fd = -1;
+    }
+#else
+    static HANDLE file = INVALID_HANDLE_VALUE, mapping = nullptr;
+
+    static void* mapFile(const std::string& path, size_t size) {
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                           nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return nullptr;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+                                     (DWORD)((uint64_t)size >> 32), (DWORD)size, nullptr);
+        void* p = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size) : nullptr;
+        if (!p) {
+            if (mapping) CloseHandle(mapping);
+            CloseHandle(file);
+            mapping = nullptr; file = INVALID_HANDLE_VALUE;
+        }
+        return p;
+    }
+
+    static void unmapFile(void* p, size_t) {
+        FlushViewOfFile(p, 0);
+        UnmapViewOfFile(p);
+        CloseHandle(mapping);
+        CloseHandle(file);
+        mapping = nullptr; file = INVALID_HANDLE_VALUE;
+    }
+#endif
+
+    bool open(const std::string& path, const std::vector<std::string>& opNames,
+              uint64_t capacity) {
+        close();
+        if (capacity == 0) return false;
+
+        uint32_t namesSize = 0;
+        for (auto& n : opNames) namesSize += (uint32_t)n.size() + 1;
+        namesSize = (namesSize + sizeof(Record) - 1) / sizeof(Record) * sizeof(Record);
+
+        uint64_t offset = sizeof(Header) + namesSize;
+        size_t   size   = (size_t)(offset + capacity * sizeof(Record));
+
+        void* base = mapFile(path, size);
+        if (!base) {
+            LOG_ERROR(IO, "Cannot map trace file: " + path);
+            return false;
+        }
+
+        Header* h = (Header*)base;
+        memset(h, 0, sizeof(Header));
+        memcpy(h->magic, MAGIC, sizeof MAGIC);
+        h->version       = VERSION;
+        h->recordSize    = sizeof(Record);
+        h->capacity      = capacity;
+        h->nameCount     = (uint32_t)opNames.size();
+        h->namesSize     = namesSize;
+        h->recordsOffset = offset;
+
+        char* names = (char*)base + sizeof(Header);
+        for (auto& n : opNames) {
+            memcpy(names, n.c_str(), n.size() + 1);
+            names += n.size() + 1;
+        }
+
+        fileSize = size;
+        records  = (Record*)((char*)base + offset);
+        written  = reinterpret_cast<std::atomic<uint64_t>*>(&h->written);
+        header   = h;
+        LOG_INFO(IO, "Tracing to " + path + " (" + std::to_string(capacity) + " records)");
+        return true;
+    }
+
+    void close() {
+        if (!header) return;
+        uint64_t n = written->load();
+        unmapFile(header, fileSize);
+        header  = nullptr;
+        records = nullptr;
+        written = nullptr;
+        LOG_INFO(IO, "Trace closed, " + std::to_string(n) + " record(s)");
+    }
+
+    Record* next() {
+        uint64_t n = written->fetch_add(1, std::memory_order_relaxed);
+        return &records[n % header->capacity];
+    }
+}
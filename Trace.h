@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary execution trace: one fixed-size record per executed instruction,
+// written straight into a memory-mapped file used as a ring (the newest
+// `capacity` records survive). tools/tracedump.cpp turns it back into text.
+//
+// File layout: Header | block type names (NUL-separated) | records
+namespace Trace {
+    const char     MAGIC[8] = {'S','C','R','T','R','A','C','E'};
+    const uint32_t VERSION  = 1;
+
+    struct Header {
+        char     magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t capacity;      // records in the ring
+        uint64_t written;       // records ever claimed; record n lives in slot n % capacity
+        uint32_t nameCount;     // names[i] is the name of BlockType i ("" = unnamed)
+        uint32_t namesSize;     // bytes, padded so records stay aligned
+        uint64_t recordsOffset; // from the start of the file
+        uint64_t reserved[2];
+    };
+
+    struct Record {
+        uint32_t tick;          // ExecutionContext::tick
+        int32_t  pc;
+        uint16_t sprite;        // Sprite::id
+        uint16_t op;            // BlockType
+        int32_t  script;        // index into Program::scripts
+        double   num[2];        // operand values as evaluated (constants if unused)
+    };
+    static_assert(sizeof(Header) == 64, "trace header layout");
+    static_assert(sizeof(Record) == 32, "trace record layout");
+
+    bool open(const std::string& path, const std::vector<std::string>& opNames,
+              uint64_t capacity = 1 << 20);
+    void close();
+
+    extern Header* header; // null while tracing is off
+    inline bool active() { return header != nullptr; }
+    Record* next();        // claim the next slot; only call when active()
+}
@@ -1,138 +1,38 @@
 #include "UIManager.h"
+#include "MemStats.h"
+#include "Font.h"
+#include "Logger.h"
 #include <cstring>
 
-// ─── 5x7 pixel font (printable ASCII 32-126) ────────────────────────────────
-static const unsigned char FONT5x7[95][7] = {
-{0x00,0x00,0x00,0x00,0x00,0x00,0x00}, // space
-{0x04,0x04,0x04,0x04,0x00,0x04,0x00}, // !
-{0x0A,0x0A,0x00,0x00,0x00,0x00,0x00}, // "
-{0x0A,0x1F,0x0A,0x0A,0x1F,0x0A,0x00}, // #
-{0x04,0x0F,0x14,0x0E,0x05,0x1E,0x04}, // $
-{0x18,0x19,0x02,0x04,0x08,0x13,0x03}, // %
-{0x0C,0x12,0x14,0x08,0x15,0x12,0x0D}, // &
-{0x04,0x04,0x00,0x00,0x00,0x00,0x00}, // '
-{0x02,0x04,0x08,0x08,0x08,0x04,0x02}, // (
-{0x08,0x04,0x02,0x02,0x02,0x04,0x08}, // )
-{0x00,0x04,0x15,0x0E,0x15,0x04,0x00}, // *
-{0x00,0x04,0x04,0x1F,0x04,0x04,0x00}, // +
-{0x00,0x00,0x00,0x00,0x04,0x04,0x08}, // ,
-{0x00,0x00,0x00,0x1F,0x00,0x00,0x00}, // -
-{0x00,0x00,0x00,0x00,0x00,0x04,0x00}, // .
-{0x01,0x01,0x02,0x04,0x08,0x10,0x10}, // /
-{0x0E,0x11,0x13,0x15,0x19,0x11,0x0E}, // 0
-{0x04,0x0C,0x04,0x04,0x04,0x04,0x0E}, // 1
-{0x0E,0x11,0x01,0x06,0x08,0x10,0x1F}, // 2
-{0x1F,0x01,0x02,0x06,0x01,0x11,0x0E}, // 3
-{0x02,0x06,0x0A,0x12,0x1F,0x02,0x02}, // 4
-{0x1F,0x10,0x1E,0x01,0x01,0x11,0x0E}, // 5
-{0x06,0x08,0x10,0x1E,0x11,0x11,0x0E}, // 6
-{0x1F,0x01,0x02,0x04,0x08,0x08,0x08}, // 7
-{0x0E,0x11,0x11,0x0E,0x11,0x11,0x0E}, // 8
-{0x0E,0x11,0x11,0x0F,0x01,0x02,0x0C}, // 9
-{0x00,0x04,0x00,0x00,0x04,0x00,0x00}, // :
-{0x00,0x04,0x00,0x00,0x04,0x04,0x08}, // ;
-{0x02,0x04,0x08,0x10,0x08,0x04,0x02}, // <
-{0x00,0x00,0x1F,0x00,0x1F,0x00,0x00}, // =
-{0x08,0x04,0x02,0x01,0x02,0x04,0x08}, // >
-{0x0E,0x11,0x01,0x02,0x04,0x00,0x04}, // ?
-{0x0E,0x11,0x17,0x15,0x17,0x10,0x0E}, // @
-{0x0E,0x11,0x11,0x1F,0x11,0x11,0x11}, // A
-{0x1E,0x11,0x11,0x1E,0x11,0x11,0x1E}, // B
-{0x0E,0x11,0x10,0x10,0x10,0x11,0x0E}, // C
-{0x1C,0x12,0x11,0x11,0x11,0x12,0x1C}, // D
-{0x1F,0x10,0x10,0x1E,0x10,0x10,0x1F}, // E
-{0x1F,0x10,0x10,0x1E,0x10,0x10,0x10}, // F
-{0x0E,0x11,0x10,0x17,0x11,0x11,0x0F}, // G
-{0x11,0x11,0x11,0x1F,0x11,0x11,0x11}, // H
-{0x0E,0x04,0x04,0x04,0x04,0x04,0x0E}, // I
-{0x07,0x02,0x02,0x02,0x02,0x12,0x0C}, // J
-{0x11,0x12,0x14,0x18,0x14,0x12,0x11}, // K
-{0x10,0x10,0x10,0x10,0x10,0x10,0x1F}, // L
-{0x11,0x1B,0x15,0x15,0x11,0x11,0x11}, // M
-{0x11,0x19,0x15,0x13,0x11,0x11,0x11}, // N
-{0x0E,0x11,0x11,0x11,0x11,0x11,0x0E}, // O
-{0x1E,0x11,0x11,0x1E,0x10,0x10,0x10}, // P
-{0x0E,0x11,0x11,0x11,0x15,0x12,0x0D}, // Q
-{0x1E,0x11,0x11,0x1E,0x14,0x12,0x11}, // R
-{0x0F,0x10,0x10,0x0E,0x01,0x01,0x1E}, // S
-{0x1F,0x04,0x04,0x04,0x04,0x04,0x04}, // T
-{0x11,0x11,0x11,0x11,0x11,0x11,0x0E}, // U
-{0x11,0x11,0x11,0x11,0x11,0x0A,0x04}, // V
-{0x11,0x11,0x15,0x15,0x15,0x15,0x0A}, // W
-{0x11,0x11,0x0A,0x04,0x0A,0x11,0x11}, // X
-{0x11,0x11,0x0A,0x04,0x04,0x04,0x04}, // Y
-{0x1F,0x01,0x02,0x04,0x08,0x10,0x1F}, // Z
-{0x0E,0x08,0x08,0x08,0x08,0x08,0x0E}, // [
-{0x10,0x10,0x08,0x04,0x02,0x01,0x01}, // backslash
-{0x0E,0x02,0x02,0x02,0x02,0x02,0x0E}, // ]
-{0x04,0x0A,0x11,0x00,0x00,0x00,0x00}, // ^
-{0x00,0x00,0x00,0x00,0x00,0x00,0x1F}, // _
-{0x08,0x04,0x00,0x00,0x00,0x00,0x00}, // `
-{0x00,0x00,0x0E,0x01,0x0F,0x11,0x0F}, // a
-{0x10,0x10,0x1E,0x11,0x11,0x11,0x1E}, // b
-{0x00,0x00,0x0E,0x10,0x10,0x10,0x0E}, // c
-{0x01,0x01,0x0F,0x11,0x11,0x11,0x0F}, // d
-{0x00,0x00,0x0E,0x11,0x1F,0x10,0x0E}, // e
-{0x06,0x09,0x08,0x1C,0x08,0x08,0x08}, // f
-{0x00,0x00,0x0F,0x11,0x0F,0x01,0x0E}, // g
-{0x10,0x10,0x16,0x19,0x11,0x11,0x11}, // h
-{0x04,0x00,0x0C,0x04,0x04,0x04,0x0E}, // i
-{0x02,0x00,0x06,0x02,0x02,0x12,0x0C}, // j
-{0x10,0x10,0x12,0x14,0x18,0x14,0x12}, // k
-{0x0C,0x04,0x04,0x04,0x04,0x04,0x0E}, // l
-{0x00,0x00,0x1A,0x15,0x15,0x11,0x11}, // m
-{0x00,0x00,0x16,0x19,0x11,0x11,0x11}, // n
-{0x00,0x00,0x0E,0x11,0x11,0x11,0x0E}, // o
-{0x00,0x00,0x1E,0x11,0x1E,0x10,0x10}, // p
-{0x00,0x00,0x0F,0x11,0x0F,0x01,0x01}, // q
-{0x00,0x00,0x16,0x19,0x10,0x10,0x10}, // r
-{0x00,0x00,0x0E,0x10,0x0E,0x01,0x1E}, // s
-{0x08,0x08,0x1C,0x08,0x08,0x09,0x06}, // t
-{0x00,0x00,0x11,0x11,0x11,0x13,0x0D}, // u
-{0x00,0x00,0x11,0x11,0x11,0x0A,0x04}, // v
-{0x00,0x00,0x11,0x15,0x15,0x15,0x0A}, // w
-{0x00,0x00,0x11,0x0A,0x04,0x0A,0x11}, // x
-{0x00,0x00,0x11,0x11,0x0F,0x01,0x0E}, // y
-{0x00,0x00,0x1F,0x02,0x04,0x08,0x1F}, // z
-{0x06,0x08,0x08,0x18,0x08,0x08,0x06}, // {
-{0x04,0x04,0x04,0x00,0x04,0x04,0x04}, // |
-{0x0C,0x02,0x02,0x03,0x02,0x02,0x0C}, // }
-{0x08,0x15,0x02,0x00,0x00,0x00,0x00}, // ~
-};
-
-void UIManager::drawChar(SDL_Renderer* r, char c, int x, int y, SDL_Color col, int s) {
-    int idx = (unsigned char)c - 32;
-    if (idx < 0 || idx >= 95) return;
-    SDL_SetRenderDrawColor(r, col.r, col.g, col.b, col.a);
-    for (int row = 0; row < 7; row++) {
-        unsigned char bits = FONT5x7[idx][row];
-        for (int col2 = 0; col2 < 5; col2++) {
-            if (bits & (0x10 >> col2)) {
-                SDL_Rect px = {x + col2*s, y + row*s, s, s};
-                SDL_RenderFillRect(r, &px);
-            }
-        }
-    }
-}
-
+// ─── text (shared Font atlas) ───────────────────────────────────────────────
 void UIManager::drawText(SDL_Renderer* r, const std::string& txt,
                          int x, int y, SDL_Color col, int s) {
-    int cx = x;
-    for (char c : txt) {
-        if (c == ' ') { cx += 4*s; continue; }
-        drawChar(r, c, cx, y, col, s);
-        cx += 6*s;
-    }
+    Font::drawText(r, txt, x, y, col, s);
+}
+
+void UIManager::drawLabel(SDL_Renderer* r, const std::string& txt,
+                          int x, int y, SDL_Color col, int s) {
+    Font::drawLabel(r, txt, x, y, col, s);
 }
 
 // ─── lifecycle ───────────────────────────────────────────────────────────────
 
 UIManager::UIManager()
     : W(1280), H(720), spriteCount(1), selectedIdx(0),
-      palScrollY(0), palContentHeight(2000), selectedCatTab(0) {}
+      palScrollY(0), palContentHeight(2000), selectedCatTab(0),
+      chrome(nullptr), dirty(0) { invalidateAll(); }
 UIManager::~UIManager() {}
 
+void UIManager::shutdown() {
+    if (!chrome) return;
+    SDL_DestroyTexture(chrome);
+    MemStats::remove(MemStats::MEM_Textures, (long long)W * H * 4);
+    chrome = nullptr;
+    invalidateAll();
+}
+
 void UIManager::init(int w, int h) {
+    shutdown();                   // chrome is recreated at the new size on next render
     W = w; H = h;
     int contH = H - UILayout::MENU_H - UILayout::SPR_H;
     int edW   = W - UILayout::PAL_W - UILayout::STAGE_W - 8;
@@ -159,6 +59,7 @@ void UIManager::init(int w, int h) {
     logPanel.visible = true;
 
     buildButtons();
+    invalidateAll();
     addLog("Ready! Drag blocks to editor.", "INFO");
 }
 
@@ -193,34 +94,97 @@ void UIManager::buildButtons() {
 
 // ─── render ──────────────────────────────────────────────────────────────────
 
+SDL_Rect UIManager::regionRect(Region rg) const {
+    int sideX = edPanel.rect.x + edPanel.rect.w;
+    switch (rg) {
+        case R_Menu:    return menuBar.rect;
+        case R_Palette: return palPanel.rect;
+        case R_Editor:  return edPanel.rect;
+        case R_Side:    return {sideX, UILayout::MENU_H, W - sideX, sprBar.rect.y - UILayout::MENU_H};
+        case R_Sprites: return sprBar.rect;
+        default:        return {0, 0, 0, 0};
+    }
+}
+
+void UIManager::renderRegion(SDL_Renderer* r, Region rg, GameState& state) {
+    switch (rg) {
+    case R_Menu:
+        SDL_SetRenderDrawColor(r,55,55,55,255);
+        SDL_RenderFillRect(r,&menuBar.rect);
+        for (auto& b:menuBtns) renderButton(r,b);
+        break;
+    case R_Palette:
+        renderPanel(r,palPanel);
+        renderCategoryTabs(r);      // tab bar at the top of the palette
+        renderScrollBar(r);         // right edge of the palette
+        break;
+    case R_Editor:
+        renderPanel(r,edPanel);
+        drawLabel(r,"Code Editor",edPanel.rect.x+6,edPanel.rect.y+6,{80,80,80,255});
+        break;
+    case R_Side: {
+        // Stage border + white fill, log below
+        SDL_SetRenderDrawColor(r,160,160,160,255);
+        SDL_Rect sb={stagePanel.rect.x-2,stagePanel.rect.y-2,
+                     stagePanel.rect.w+4,stagePanel.rect.h+4};
+        SDL_RenderFillRect(r,&sb);
+        SDL_SetRenderDrawColor(r,255,255,255,255);
+        SDL_RenderFillRect(r,&stagePanel.rect);
+        if (logPanel.visible) renderLog(r);
+        break;
+    }
+    case R_Sprites:
+        renderSprBar(r,state);
+        break;
+    default: break;
+    }
+}
+
+// Redraws dirty regions into `chrome`; false if render targets are unavailable
+bool UIManager::updateChrome(SDL_Renderer* r, GameState& state) {
+    static bool unsupported = false;
+    if (unsupported) return false;
+    if (!chrome) {
+        chrome = SDL_CreateTexture(r, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, W, H);
+        if (!chrome) {
+            unsupported = true;
+            LOG_WARN(Renderer, std::string("UI panels not cached: ") + SDL_GetError());
+            return false;
+        }
+        SDL_SetTextureBlendMode(chrome, SDL_BLENDMODE_NONE); // opaque, covers the window
+        MemStats::add(MemStats::MEM_Textures, (long long)W * H * 4);
+        invalidateAll();
+    }
+    if (!dirty) return true;
+
+    SDL_Texture* prev = SDL_GetRenderTarget(r);
+    SDL_SetRenderTarget(r, chrome);
+    for (int rg = 0; rg < R_Count; rg++) {
+        if (!(dirty & (1u << rg))) continue;
+        SDL_Rect area = regionRect((Region)rg);
+        SDL_RenderSetClipRect(r, &area);
+        SDL_SetRenderDrawColor(r,220,220,220,255); // window background
+        SDL_RenderFillRect(r, &area);
+        renderRegion(r, (Region)rg, state);
+    }
+    SDL_RenderSetClipRect(r, nullptr);
+    SDL_SetRenderTarget(r, prev);
+    dirty = 0;
+    return true;
+}
+
 void UIManager::render(SDL_Renderer* r, GameState& state) {
-    // Menu bar
-    SDL_SetRenderDrawColor(r,55,55,55,255);
-    SDL_RenderFillRect(r,&menuBar.rect);
-    for (auto& b:menuBtns) renderButton(r,b);
-
-    // Palette + editor panels
-    renderPanel(r,palPanel);
-    renderPanel(r,edPanel);
-    drawText(r,"Code Editor",edPanel.rect.x+6,edPanel.rect.y+6,{80,80,80,255});
-
-    // Category tab bar inside palette (top of palette)
-    renderCategoryTabs(r);
-
-    // Scrollbar on right edge of palette
-    renderScrollBar(r);
-
-    // Stage border + white fill
-    SDL_SetRenderDrawColor(r,160,160,160,255);
-    SDL_Rect sb={stagePanel.rect.x-2,stagePanel.rect.y-2,
-                 stagePanel.rect.w+4,stagePanel.rect.h+4};
-    SDL_RenderFillRect(r,&sb);
-    SDL_SetRenderDrawColor(r,255,255,255,255);
-    SDL_RenderFillRect(r,&stagePanel.rect);
-
-    // Sprite bar + log
-    renderSprBar(r,state);
-    if (logPanel.visible) renderLog(r);
+    // The sprite bar lists variable values, which scripts change at will
+    std::string vars;
+    for (int i = 0; i < state.variables.size(); i++)
+        vars += state.variables.names[i] + '\0' + toString(state.variables.values[i]) + '\0';
+    if (vars != sprBarShown) { sprBarShown.swap(vars); invalidate(R_Sprites); }
+
+    if (updateChrome(r, state)) {
+        SDL_RenderCopy(r, chrome, nullptr, nullptr);
+        return;
+    }
+    for (int rg = 0; rg < R_Count; rg++) renderRegion(r, (Region)rg, state);
 }
 
 void UIManager::renderCategoryTabs(SDL_Renderer* r) {
@@ -263,7 +227,7 @@ void UIManager::renderCategoryTabs(SDL_Renderer* r) {
         int tw = (int)strlen(cats[i].name)*6;
         int tx = tab.x + (tab.w - tw)/2;
         int ty = tab.y + (tab.h - 7)/2;
-        drawText(r, cats[i].name, tx, ty, {255,255,255,255});
+        drawLabel(r, cats[i].name, tx, ty, {255,255,255,255});
     }
 }
 
@@ -311,7 +275,7 @@ void UIManager::renderButton(SDL_Renderer* r, const Button& b) {
     int tw = (int)b.label.size() * 6;
     int tx = b.rect.x + (b.rect.w - tw)/2;
     int ty = b.rect.y + (b.rect.h - 7)/2;
-    drawText(r, b.label, tx, ty, {255,255,255,255});
+    drawLabel(r, b.label, tx, ty, {255,255,255,255});
 }
 
 void UIManager::renderLog(SDL_Renderer* r) {
@@ -324,8 +288,8 @@ void UIManager::renderLog(SDL_Renderer* r) {
     SDL_Rect ts={logPanel.rect.x,logPanel.rect.y,logPanel.rect.w,16};
     SDL_SetRenderDrawColor(r,45,45,45,255);
     SDL_RenderFillRect(r,&ts);
-    drawText(r,"Console",logPanel.rect.x+4,logPanel.rect.y+4,{170,170,170,255});
-    drawText(r,"Clear",logPanel.rect.x+logPanel.rect.w-34,logPanel.rect.y+4,{255,80,80,255});
+    drawLabel(r,"Console",logPanel.rect.x+4,logPanel.rect.y+4,{170,170,170,255});
+    drawLabel(r,"Clear",logPanel.rect.x+logPanel.rect.w-34,logPanel.rect.y+4,{255,80,80,255});
 
     int lh=12, yp=logPanel.rect.y+20;
     int maxL=(logPanel.rect.h-22)/lh;
@@ -347,7 +311,7 @@ void UIManager::renderSprBar(SDL_Renderer* r,GameState& state) {
     SDL_RenderFillRect(r,&sprBar.rect);
     SDL_SetRenderDrawColor(r,190,190,190,255);
     SDL_RenderDrawRect(r,&sprBar.rect);
-    drawText(r,"Sprites",8,sprBar.rect.y+4,{80,80,80,255});
+    drawLabel(r,"Sprites",8,sprBar.rect.y+4,{80,80,80,255});
 
     for (auto& b:sprBtns) renderButton(r,b);
 
@@ -369,17 +333,17 @@ void UIManager::renderSprBar(SDL_Renderer* r,GameState& state) {
         SDL_RenderFillRect(r,&icon);
 
         std::string nm="Spr"+std::to_string(i+1);
-        drawText(r,nm,sx+10,sy+sz-14,{60,60,60,255});
+        drawLabel(r,nm,sx+10,sy+sz-14,{60,60,60,255});
         sx+=sz+gap;
     }
 
     int vy = sprBar.rect.y + sprBar.rect.h-30;
-    drawText(r,"Variables",sx,vy,{80,80,80,255});
+    drawLabel(r,"Variables",sx,vy,{80,80,80,255});
     vy+=15;
     int vx = 8;
-    for (auto& var : state.variables)
+    for (int i = 0; i < state.variables.size(); i++)
     {
-        std::string text= var.first + ": " + var.second;
+        std::string text= state.variables.names[i] + ": " + toString(state.variables.values[i]);
         drawText(r,text,sx,vy,{200,100,50,255});
         vx+=120;
         if (vx>300)
@@ -393,8 +357,8 @@ void UIManager::renderSprBar(SDL_Renderer* r,GameState& state) {
 // ─── input ───────────────────────────────────────────────────────────────────
 
 void UIManager::handleMouseMove(int x,int y) {
-    for (auto& b:menuBtns) b.isHovered=hit(x,y,b.rect);
-    for (auto& b:sprBtns)  b.isHovered=hit(x,y,b.rect);
+    for (auto& b:menuBtns) { bool h=hit(x,y,b.rect); if (h!=b.isHovered) { b.isHovered=h; invalidate(R_Menu); } }
+    for (auto& b:sprBtns)  { bool h=hit(x,y,b.rect); if (h!=b.isHovered) { b.isHovered=h; invalidate(R_Sprites); } }
 }
 
 void UIManager::handleMouseWheel(int mx, int /*my*/, int deltaY) {
@@ -407,6 +371,7 @@ void UIManager::handleMouseWheel(int mx, int /*my*/, int deltaY) {
         if (maxScroll < 0) maxScroll = 0;
         if (palScrollY < 0)         palScrollY = 0;
         if (palScrollY > maxScroll) palScrollY = maxScroll;
+        invalidate(R_Palette);
     }
 }
 
@@ -425,6 +390,7 @@ void UIManager::handleMouseClick(int x,int y,bool down) {
         if (tab >= 0 && tab < N) {
             selectedCatTab = tab;
             palScrollY = 0;   // jump to top on category change
+            invalidate(R_Palette);
             return;
         }
     }
@@ -436,7 +402,7 @@ void UIManager::handleMouseClick(int x,int y,bool down) {
     int sx=76,sy=sprBar.rect.y+8,sz=78,gap=6;
     for (int i=0;i<spriteCount;i++) {
         SDL_Rect box={sx,sy,sz,sz};
-        if (hit(x,y,box)){selectedIdx=i;return;}
+        if (hit(x,y,box)){selectedIdx=i;invalidate(R_Sprites);return;}
         sx+=sz+gap;
     }
     // Clear log button
@@ -457,12 +423,24 @@ void UIManager::resetButtons() {
     for (auto& b:sprBtns)  b.isPressed=false;
 }
 
+static long long logBytes(const UIManager::LogEntry& e) {
+    return (long long)(sizeof(e) + e.msg.capacity() + e.level.capacity());
+}
 void UIManager::addLog(const std::string& msg,const std::string& level) {
     logs.push_back({msg,level});
-    if ((int)logs.size()>80) logs.erase(logs.begin());
+    invalidate(R_Side);
+    MemStats::add(MemStats::MEM_Logs, logBytes(logs.back()));
+    if ((int)logs.size()>80) {
+        MemStats::remove(MemStats::MEM_Logs, logBytes(logs.front()));
+        logs.erase(logs.begin());
+    }
+}
+void UIManager::clearLogs()  {
+    for (auto& e : logs) MemStats::remove(MemStats::MEM_Logs, logBytes(e));
+    logs.clear();
+    invalidate(R_Side);
 }
-void UIManager::clearLogs()  { logs.clear(); }
-void UIManager::toggleLogPanel() { logPanel.visible=!logPanel.visible; }
+void UIManager::toggleLogPanel() { logPanel.visible=!logPanel.visible; invalidate(R_Side); }
 
 bool UIManager::hit(int x,int y,const SDL_Rect& r) const {
     return x>=r.x&&x<=r.x+r.w&&y>=r.y&&y<=r.y+r.h;
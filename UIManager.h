@@ -37,6 +37,7 @@ struct UIManager {
 
 
     void init(int w, int h);
+    void shutdown(); // before the renderer is destroyed; drops the chrome texture
     void render(SDL_Renderer* r, GameState& state);
     void handleMouseMove(int x, int y);
     void handleMouseClick(int x, int y, bool down, GameState& state);
@@ -49,10 +50,17 @@ struct UIManager {
     void clearLogs();
     void toggleLogPanel();
 
-    void setSpriteCount(int n)          { spriteCount=n; }
+    void setSpriteCount(int n)          { if (n!=spriteCount) { spriteCount=n; invalidate(R_Sprites); } }
     int  getSelectedSpriteIndex() const { return selectedIdx; }
     int  getPaletteScrollY()      const { return palScrollY; }
-    void setPaletteContentHeight(int h) { palContentHeight = h; }
+    void setPaletteContentHeight(int h) { if (h!=palContentHeight) { palContentHeight=h; invalidate(R_Palette); } }
+
+    // Retained chrome: render() keeps every panel in one window-sized texture
+    // and redraws only the regions marked dirty, then blits it once. Anything
+    // that changes what a region shows must invalidate it.
+    enum Region { R_Menu, R_Palette, R_Editor, R_Side, R_Sprites, R_Count }; // R_Side: stage frame + log
+    void invalidate(Region rg) { dirty |= 1u << rg; }
+    void invalidateAll()       { dirty = (1u << R_Count) - 1; }
 
     SDL_Rect getStageRect()    const { return stagePanel.rect; }
     SDL_Rect getPaletteRect()  const { return palPanel.rect;   }
@@ -79,6 +87,14 @@ struct UIManager {
     struct LogEntry { std::string msg,level; };
     std::vector<LogEntry> logs;
 
+    SDL_Texture* chrome;       // retained panels, W x H
+    unsigned     dirty;        // Region bits
+    std::string  sprBarShown;  // variable text last drawn in the sprite bar
+
+    SDL_Rect regionRect(Region rg) const;
+    void     renderRegion(SDL_Renderer*, Region rg, GameState& state);
+    bool     updateChrome(SDL_Renderer*, GameState& state);
+
     void buildButtons();
     void renderPanel       (SDL_Renderer*, const UIPanel&);
     void renderButton      (SDL_Renderer*, const Button&);
@@ -87,10 +103,12 @@ struct UIManager {
     void renderCategoryTabs(SDL_Renderer*);
     void renderScrollBar   (SDL_Renderer*);
 
-    // Built-in pixel text — no SDL_ttf needed
+    // Built-in pixel text (Font atlas) — no SDL_ttf needed
     void drawText(SDL_Renderer*, const std::string&, int x, int y,
                   SDL_Color col={255,255,255,255}, int scale=1);
-    void drawChar(SDL_Renderer*, char c, int x, int y, SDL_Color col, int scale);
+    // Same, cached per (text, colour, scale) for captions that rarely change
+    void drawLabel(SDL_Renderer*, const std::string&, int x, int y,
+                   SDL_Color col={255,255,255,255}, int scale=1);
 
     bool hit(int x,int y,const SDL_Rect& r) const;
 };
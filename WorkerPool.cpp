@@ -0,0 +1,108 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int workers)
+    : job(nullptr), pending(0), active(0), generation(0), quit(false)
+{
+    if (workers <= 0) workers = (int)std::thread::hardware_concurrency() - 1;
+    if (workers < 0)  workers = 0;
+
+    for (int i = 0; i <= workers; i++)
+        queues.emplace_back(new Queue());
+    for (int i = 1; i <= workers; i++)
+        threads.emplace_back(&WorkerPool::workerLoop, this, i);
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m);
+        quit = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void WorkerPool::run(int count, const std::function<void(int)>& fn) {
+    if (count <= 0) return;
+    if (threads.empty()) {
+        for (int i = 0; i < count; i++) fn(i);
+        return;
+    }
+
+    // Deal contiguous chunks so neighbouring tasks start on the same worker
+    int n = size();
+    for (int q = 0; q < n; q++) {
+        std::lock_guard<std::mutex> lock(queues[q]->m);
+        for (int i = q * count / n; i < (q + 1) * count / n; i++)
+            queues[q]->tasks.push_back(i);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m);
+        job     = &fn;
+        pending = count;
+        generation++;
+    }
+    wake.notify_all();
+
+    work(0, fn);
+
+    // Also wait for workers to leave work(), so none carries `fn` into the next run
+    std::unique_lock<std::mutex> lock(m);
+    done.wait(lock, [this] { return pending == 0 && active == 0; });
+    job = nullptr;
+}
+
+bool WorkerPool::next(int self, int& task) {
+    {
+        Queue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.m);
+        if (!own.tasks.empty()) {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    int n = size();
+    for (int k = 1; k < n; k++) {
+        Queue& victim = *queues[(self + k) % n];
+        std::lock_guard<std::mutex> lock(victim.m);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::work(int self, const std::function<void(int)>& fn) {
+    int task;
+    while (next(self, task)) {
+        fn(task);
+        if (--pending == 0) {
+            std::lock_guard<std::mutex> lock(m);
+            done.notify_all();
+        }
+    }
+}
+
+void WorkerPool::workerLoop(int self) {
+    unsigned seen = 0;
+    for (;;) {
+        const std::function<void(int)>* fn;
+        {
+            std::unique_lock<std::mutex> lock(m);
+            wake.wait(lock, [&] { return quit || generation != seen; });
+            if (quit) return;
+            seen = generation;
+            fn   = job;
+            active++;
+        }
+        if (fn) work(self, *fn);
+        {
+            std::lock_guard<std::mutex> lock(m);
+            active--;
+        }
+        done.notify_all();
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel jobs. Every participant
+// (workers plus the calling thread) owns a deque of task indices: it pops
+// from its own front and, once that runs dry, steals from the back of
+// another participant's deque.
+struct WorkerPool {
+    explicit WorkerPool(int workers = 0); // 0 = one per hardware thread, minus the caller
+    ~WorkerPool();
+
+    // Run job(i) for every i in [0, count); returns when all have finished.
+    // The calling thread works on the job too.
+    void run(int count, const std::function<void(int)>& job);
+    int  size() const { return (int)queues.size(); } // participants incl. caller
+
+private:
+    struct Queue {
+        std::mutex      m;
+        std::deque<int> tasks;
+    };
+
+    void workerLoop(int self);
+    bool next(int self, int& task);   // own front, else steal
+    void work(int self, const std::function<void(int)>& fn);
+
+    std::vector<std::unique_ptr<Queue>> queues; // [0] = calling thread
+    std::vector<std::thread>            threads;
+
+    const std::function<void(int)>* job;
+    std::atomic<int>        pending;  // tasks not finished yet
+    int                     active;   // workers inside work() (guarded by m)
+    std::mutex              m;
+    std::condition_variable wake, done;
+    unsigned                generation;
+    bool                    quit;
+};
@@ -6,33 +6,55 @@
 #include "Logger.h"
 #include "SaveLoad.h"
 #include "UIManager.h"
+#include "Trace.h"
+#include "Profiler.h"
+#include "FrameStats.h"
+#include "MemStats.h"
+#include "Font.h"
+#include "Effects.h"
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_mixer.h>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
 // Forward declarations
-bool  initSDL   (GameState& state);
+bool  initSDL   (GameState& state, bool headless);
 bool  loadAssets(GameState& state);
 void  initPalette(GameState& state);
 void  gameLoop  (GameState& state, UIManager& ui);
+void  headlessLoop(GameState& state, int ticks);
+void  showProfile(GameState& state, UIManager& ui);
 
 // ─── Entry point ─────────────────────────────────────────────────────────────
 int main(int argc, char* argv[]) {
     Logger::init("scratch.log");
     Logger::info("=== Scratch Clone Starting ===");
 
+    // --headless N: run N ticks as fast as possible, no window, a fixed
+    //                number of script passes per tick
+    // --trace FILE:  binary execution trace (see tools/tracedump.cpp)
+    int         headlessTicks = 0;
+    std::string projectPath, tracePath;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if      (arg == "--headless" && i + 1 < argc) headlessTicks = std::atoi(argv[++i]);
+        else if (arg == "--trace"    && i + 1 < argc) tracePath     = argv[++i];
+        else                                           projectPath   = arg;
+    }
+    bool headless = headlessTicks > 0;
+
     GameState  state;
 
 
     UIManager  ui;
 
-    if (!initSDL(state)) {
+    if (!initSDL(state, headless)) {
         std::cerr << "Failed to initialize SDL!" << std::endl;
         return 1;
     }
 
-    ui.init(state.windowWidth, state.windowHeight);
+    if (!headless) ui.init(state.windowWidth, state.windowHeight);
 
     if (!loadAssets(state)) {
         Logger::warning("Some assets were not loaded");
@@ -40,13 +62,34 @@ int main(int argc, char* argv[]) {
 
     initPalette(state);
 
-    ui.addLog("Scratch Clone ready!", "INFO");
-    ui.addLog("Drag blocks from palette -> editor", "INFO");
-    ui.addLog("Press SPACE to run, S = step mode", "INFO");
+    if (!projectPath.empty()) SaveLoad::loadProject(state, projectPath);
+
+    if (!tracePath.empty()) {
+        std::vector<std::string> opNames;
+        for (int t = 0; t <= BLOCK_None; t++)
+            opNames.push_back(SaveLoad::typeName((BlockType)t));
+        Trace::open(tracePath, opNames);
+    }
 
-    gameLoop(state, ui);
+    if (headless) {
+        headlessLoop(state, headlessTicks);
+    } else {
+        ui.addLog("Scratch Clone ready!", "INFO");
+        ui.addLog("Drag blocks from palette -> editor", "INFO");
+        ui.addLog("Press SPACE to run, S = step mode", "INFO");
+
+        gameLoop(state, ui);
+    }
 
     // Cleanup
+    Trace::close();
+    Font::shutdown();
+    Effects::shutdown();
+    ui.shutdown();
+    if (state.penLayer) {
+        SDL_DestroyTexture(state.penLayer);
+        state.penLayer = nullptr;
+    }
     SDL_DestroyRenderer(state.renderer);
     SDL_DestroyWindow(state.window);
     Mix_Quit();
@@ -57,8 +100,9 @@ int main(int argc, char* argv[]) {
 }
 
 // ─── SDL init ─────────────────────────────────────────────────────────────────
-bool initSDL(GameState& state) {
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
+bool initSDL(GameState& state, bool headless) {
+    Uint32 systems = headless ? SDL_INIT_VIDEO : SDL_INIT_VIDEO | SDL_INIT_AUDIO;
+    if (SDL_Init(systems) < 0) {
         std::cerr << "SDL_Init failed: " << SDL_GetError() << std::endl;
         return false;
     }
@@ -67,7 +111,7 @@ bool initSDL(GameState& state) {
         Logger::warning("IMG_Init warning: " + std::string(IMG_GetError()));
     }
 
-    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
+    if (!headless && Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
         Logger::warning("Mix_OpenAudio failed: " + std::string(SDL_GetError()));
     }
 
@@ -75,7 +119,7 @@ bool initSDL(GameState& state) {
         "Scratch Clone \xe2\x80\x94 C++/SDL2",
         SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
         state.windowWidth, state.windowHeight,
-        SDL_WINDOW_SHOWN);
+        headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN); // headless still needs textures
 
     if (!state.window) {
         std::cerr << "Window failed: " << SDL_GetError() << std::endl;
@@ -83,7 +127,8 @@ bool initSDL(GameState& state) {
     }
 
     state.renderer = SDL_CreateRenderer(state.window, -1,
-        SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+        headless ? SDL_RENDERER_SOFTWARE
+                 : SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     if (!state.renderer) {
         std::cerr << "Renderer failed: " << SDL_GetError() << std::endl;
         return false;
@@ -101,15 +146,12 @@ bool loadAssets(GameState& state) {
     SpriteGen::generateAllSprites(state.renderer);
 
 
-    for (auto* s : state.sprites) delete s;
-    state.sprites.clear();
+    state.clearSprites();
 
 
 
     Sprite* cat = new Sprite();
     cat->name = "Cat1";
-    cat->x = 0;
-    cat->y = 0;
 
     SDL_Surface* catSurface = IMG_Load("assets/cat.png");
     if (catSurface) {
@@ -125,6 +167,7 @@ bool loadAssets(GameState& state) {
         c.height = (int)(originalH * scale);
 
         c.texture = SDL_CreateTextureFromSurface(state.renderer, catSurface);
+        Effects::keepPixels(c, catSurface);
         SDL_FreeSurface(catSurface);
 
         cat->costumes.push_back(c);
@@ -132,31 +175,33 @@ bool loadAssets(GameState& state) {
     } else {
         Logger::warning("Failed to load cat.png");
     }
-    state.sprites.push_back(cat);
+    state.addSprite(cat);
     // ============================
 
 
     Sprite* shapes = new Sprite();
     shapes->name = "Shape1";
-    shapes->x = 0;
-    shapes->y = 0;
 
     const char* names[] = {"circle","square","triangle","star",
                            "hexagon","pentagon","diamond","arrow"};
 
     for (auto* nm : names) {
-        SDL_Texture* tex = SpriteGen::createTextureFor(state.renderer, nm);
+        SDL_Surface* surface = SpriteGen::createSurfaceFor(nm);
+        if (!surface) continue;
+        SDL_Texture* tex = SDL_CreateTextureFromSurface(state.renderer, surface);
         if (tex) {
             Costume c;
             c.name = nm;
             c.texture = tex;
             c.width = 80;
             c.height = 80;
+            Effects::keepPixels(c, surface);
             shapes->costumes.push_back(c);
         }
+        SDL_FreeSurface(surface);
     }
 
-    state.sprites.push_back(shapes);
+    state.addSprite(shapes);
     // ================================
 
     return true;
@@ -272,6 +317,7 @@ void initPalette(GameState& state) {
     add(BLOCK_WhenKeyPressed, CAT_EVENTS,  "when space key pressed",0,"space");
     add(BLOCK_WhenSpriteClicked, CAT_EVENTS,"when this sprite clicked",0);
     add(BLOCK_Broadcast,CAT_EVENTS,"broadcast message1",0,"message1");
+    add(BLOCK_BroadcastAndWait,CAT_EVENTS,"broadcast message1 and wait",0,"message1");
     add(BLOCK_WhenReceive,CAT_EVENTS,"when I receive message1",0,"message1");
     // ── PEN (dark green) ──────────────────────────────────────────────────
     y = state.paletteBlocks.back()->y + spacing;
@@ -283,6 +329,8 @@ void initPalette(GameState& state) {
     add(BLOCK_ChangePenSize,     CAT_PEN,       "change pen size by 1",  1);
     add(BLOCK_Stamp,             CAT_PEN,       "stamp",                 0);
 
+    state.paletteIndex.rebuild(state.paletteBlocks);
+
     Logger::info("Palette initialized with " +
                  std::to_string(state.paletteBlocks.size()) + " blocks");
 }
@@ -291,13 +339,33 @@ void initPalette(GameState& state) {
 void gameLoop(GameState& state, UIManager& ui) {
     bool running = true;
     SDL_Event event;
-    Uint32 lastTime = SDL_GetTicks();
+
+    // Fixed timestep: the engine always advances by whole ticks, however
+    // fast frames are presented; leftover time carries to the next frame
+    const float  tick     = 1.0f / Engine::TICK_RATE;
+    const Uint64 freq     = SDL_GetPerformanceFrequency();
+    Uint64       lastTime = SDL_GetPerformanceCounter();
+    double       lag      = 0;
+
+    // Without vsync nothing paces the presents, so the loop sleeps instead
+    SDL_RendererInfo info;
+    const bool vsync = SDL_GetRendererInfo(state.renderer, &info) == 0 &&
+                       (info.flags & SDL_RENDERER_PRESENTVSYNC);
+
+    // F4 reaches the keyboard through Input, the report goes to the log panel
+    Input::setProfileReport([&ui](GameState& s) { showProfile(s, ui); });
 
     while (running) {
+        FrameStats::beginFrame();
+
         // ── Event processing ──────────────────────────────────────────────
+        FrameStats::begin(FrameStats::PH_Events);
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT) {
                 running = false;
+            } else if (event.type == SDL_RENDER_TARGETS_RESET) {
+                ui.invalidateAll();              // cached panels were lost
+                Input::handleEvent(state, event);
             } else if (event.type == SDL_MOUSEWHEEL) {
                 // Forward scroll to UIManager for palette scrolling
                 ui.handleMouseWheel(state.mouseX, state.mouseY, event.wheel.y);
@@ -313,6 +381,7 @@ void gameLoop(GameState& state, UIManager& ui) {
                 Input::handleEvent(state, event);
             }
         }
+        FrameStats::end(FrameStats::PH_Events);
 
         // Sync palette scroll offset from UIManager → GameState
         state.paletteScrollY = ui.getPaletteScrollY();
@@ -352,9 +421,8 @@ void gameLoop(GameState& state, UIManager& ui) {
             ui.addLog("Project loaded", "INFO");
         }
         if (ui.isButtonPressed(UIManager::BTN_NEW_PROJECT)) {
-            for (auto* b : state.editorBlocks) delete b;
-            state.editorBlocks.clear();
-            state.penStrokes.clear();
+            state.clearScripts();
+            state.clearPen();
             state.variables.clear();
             state.exec.running = false;
             ui.addLog("New project created", "INFO");
@@ -387,7 +455,7 @@ void gameLoop(GameState& state, UIManager& ui) {
                 ui.addLog("New shape added!", "INFO");
             }
 
-            state.sprites.push_back(ns);
+            state.addSprite(ns);
             ui.setSpriteCount((int)state.sprites.size());
         }
         if (ui.isButtonPressed(UIManager::BTN_CLEAR_LOG)) {
@@ -401,7 +469,7 @@ void gameLoop(GameState& state, UIManager& ui) {
         ui.setSpriteCount((int)state.sprites.size());
         int sel = ui.getSelectedSpriteIndex();
         if (sel >= 0 && sel < (int)state.sprites.size())
-            state.selectedSpriteIndex = sel;
+            state.selectSprite(sel); // swaps the editor to that sprite's scripts
 
         // Tell UIManager how tall the palette content is (for scrollbar)
         if (!state.paletteBlocks.empty()) {
@@ -448,12 +516,17 @@ void gameLoop(GameState& state, UIManager& ui) {
         else                   SDL_StopTextInput();
 
         // ── Update ────────────────────────────────────────────────────────
-        Uint32 now = SDL_GetTicks();
-        float  dt  = (now - lastTime) / 1000.0f;
-        if (dt > 0.1f) dt = 0.1f;  // cap at 100ms to avoid huge jumps
+        Uint64 now = SDL_GetPerformanceCounter();
+        lag       += (double)(now - lastTime) / freq;
         lastTime   = now;
+        if (lag > 4 * tick) lag = 4 * tick; // after a stall, drop time instead of catching up
 
-        Engine::update(state, dt);
+        FrameStats::begin(FrameStats::PH_Update);
+        while (lag >= tick) {
+            Engine::update(state, tick);
+            lag -= tick;
+        }
+        FrameStats::end(FrameStats::PH_Update);
 
         // Sync layout from UIManager
         SDL_Rect sr = ui.getStageRect();
@@ -474,23 +547,32 @@ void gameLoop(GameState& state, UIManager& ui) {
         SDL_RenderClear(state.renderer);
 
         // 1. UI chrome (menu, panels, sprite bar, log)
+        FrameStats::begin(FrameStats::PH_UI);
         ui.render(state.renderer, state);
+        FrameStats::end(FrameStats::PH_UI);
 
         // 2. Palette blocks
+        FrameStats::begin(FrameStats::PH_Palette);
         Renderer::renderPaletteBlocks(state);
+        FrameStats::end(FrameStats::PH_Palette);
 
         // 3. Editor blocks + execution cursor (step mode)
+        // 4. Snap preview while dragging
+        FrameStats::begin(FrameStats::PH_Editor);
         Renderer::renderEditorBlocks(state);
         Renderer::renderExecutionCursor(state);
-
-        // 4. Snap preview while dragging
         Renderer::renderSnapPreview(state);
+        FrameStats::end(FrameStats::PH_Editor);
 
         // 5. Stage content (pen layer + sprites + speech bubbles)
+        FrameStats::begin(FrameStats::PH_Stage);
         Renderer::renderStageContent(state);
+        FrameStats::end(FrameStats::PH_Stage);
 
         // 6. Variable monitor overlay
+        FrameStats::begin(FrameStats::PH_Monitor);
         Renderer::renderVariableMonitor(state);
+        FrameStats::end(FrameStats::PH_Monitor);
 
         // 7. Dragged block (top-most)
         if (state.draggedBlock)
@@ -499,7 +581,63 @@ void gameLoop(GameState& state, UIManager& ui) {
         // 8. Ask/answer dialog (modal)
         Renderer::renderAskDialog(state);
 
-        SDL_RenderPresent(state.renderer);
-        SDL_Delay(16); // ~60 FPS
+        // 9. Frame timing overlay (F5)
+        if (FrameStats::showOverlay)
+            Renderer::renderFrameStats(state);
+        if (MemStats::showOverlay)          // F7
+            Renderer::renderMemStats(state);
+
+        // Rendering is queued until here, so "present" includes GPU work
+        // still pending and the vsync wait
+        FrameStats::begin(FrameStats::PH_Present);
+        SDL_RenderPresent(state.renderer); // paced by vsync
+        if (!vsync) {
+            // Sleep until the next tick is due instead of spinning a core
+            double due = lag + (double)(SDL_GetPerformanceCounter() - lastTime) / freq;
+            if (due < tick) SDL_Delay((Uint32)((tick - due) * 1000));
+        }
+        FrameStats::end(FrameStats::PH_Present);
+
+        FrameStats::endFrame();
     }
+}
+
+// ─── Profiler report (F4) ─────────────────────────────────────────────────────
+// Top block types in the console, full breakdown to profile.csv and
+// profile.folded (flamegraph.pl / speedscope)
+void showProfile(GameState& state, UIManager& ui) {
+    std::vector<std::string> lines = Profiler::summary(8);
+    if (lines.empty()) {
+        ui.addLog("Profile empty: F3, then run", "WARNING");
+        return;
+    }
+    ui.addLog("Profile (self time):", "INFO");
+    for (auto& l : lines) ui.addLog(l, "PROF");
+    Profiler::exportCSV(state, "profile.csv");
+    Profiler::exportFolded(state, "profile.folded");
+    ui.addLog("Saved profile.csv / .folded", "INFO");
+}
+
+// ─── Headless loop ────────────────────────────────────────────────────────────
+// Green flag, then `ticks` engine ticks back to back: no events, no
+// rendering, no frame pacing. Stops early once the program has ended.
+void headlessLoop(GameState& state, int ticks) {
+    const float  tick  = 1.0f / Engine::TICK_RATE;
+    const Uint64 freq  = SDL_GetPerformanceFrequency();
+    const Uint64 start = SDL_GetPerformanceCounter();
+
+    state.exec.passLimit = Engine::HEADLESS_PASSES; // reproducible, unlike a time budget
+    Engine::startExecution(state);
+    int done = 0;
+    while (done < ticks && state.exec.running) {
+        Engine::update(state, tick);
+        done++;
+    }
+
+    double wall = (double)(SDL_GetPerformanceCounter() - start) / freq;
+    std::string summary = "Headless: " + std::to_string(done) + " tick(s), " +
+                          std::to_string(done * tick) + "s simulated in " +
+                          std::to_string(wall) + "s";
+    Logger::info(summary);
+    std::cout << summary << std::endl;
 }
\ No newline at end of file
@@ -0,0 +1,176 @@
+// parallel_check — run the same project serially and on the worker pool and
+// compare the end state; the serial run is the reference
+//
+//   g++ -std=c++17 -O2 -I.. parallel_check.cpp ../Engine.cpp ../Compiler.cpp ../SaveLoad.cpp
+//       ../GameState.cpp ../WorkerPool.cpp ../Logger.cpp ../Trace.cpp
+//       ../Profiler.cpp ../MemStats.cpp ../Timeline.cpp
+//       $(sdl2-config --cflags --libs) -lSDL2_mixer -pthread -o parallel_check
+//   parallel_check [SPRITES] [TICKS]
+//
+// Most sprites are independent: they set and change variables nobody else
+// reads, draw random numbers, move, change layer, stamp and broadcast. Every
+// tenth one reads a variable the others write, and the middle one stops all.
+// A second project checks that a read sees a write made earlier in the same
+// pass (A: set v to 5, B: set v to v + 1 gives 6). Exits 0 when both modes
+// end in the same state, 1 (naming the first difference) otherwise. Add
+// -fsanitize=thread to the build to check the parallel passes for races.
+#include "GameState.h"
+#include "Engine.h"
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+static Block* block(BlockType type, double num = 0, const std::string& str = "",
+                    std::initializer_list<Block*> inputs = {}) {
+    Block* b = new Block();
+    b->type        = type;
+    b->numberValue = num;
+    b->stringValue = str;
+    b->inputs      = inputs;
+    return b;
+}
+
+static Block* lit(double v) { return block(BLOCK_Literal, v); }
+static Block* var(const std::string& name) { return block(BLOCK_ChangeVariable, 0, name); }
+
+static void stack(std::vector<Block*>& blocks, std::initializer_list<Block*> chain) {
+    Block* prev = nullptr;
+    for (Block* b : chain) {
+        blocks.push_back(b);
+        if (prev) prev->nextBlock = b;
+        prev = b;
+    }
+}
+
+static void buildProject(GameState& gs, int sprites) {
+    for (int i = 0; i < sprites; i++) {
+        Sprite* sp = new Sprite();
+        sp->name = "Sprite" + std::to_string(i + 1);
+        gs.addSprite(sp);
+        std::vector<Block*>& blocks = gs.scriptsOf(sp);
+
+        Block* loop = block(BLOCK_Repeat, 40);
+        loop->nested.push_back(block(BLOCK_SetVariable, i, "last"));
+        loop->nested.push_back(block(BLOCK_ChangeVariable, 1, "count"));
+        if (i % 10 == 0) {
+            // acc = acc + i: sees every write made earlier in the pass
+            loop->nested.push_back(block(BLOCK_SetVariable, 0, "acc",
+                                   {block(BLOCK_Add, 0, "", {var("acc"), lit(i)})}));
+            loop->nested.push_back(block(BLOCK_TurnRight, 0, "", {var("acc")}));
+        }
+        loop->nested.push_back(block(BLOCK_ChangeX, 0, "",
+                               {block(BLOCK_Random, 0, "", {lit(-5), lit(5)})}));
+        if (i % 3 == 0) loop->nested.push_back(block(BLOCK_GoToFrontLayer));
+        if (i % 7 == 0) loop->nested.push_back(block(BLOCK_Stamp));
+        loop->nested.push_back(block(BLOCK_Broadcast, 0, "ping"));
+        if (i == sprites / 2) {
+            // Stops all a few iterations before the others finish
+            loop->numberValue = 35;
+            stack(blocks, {block(BLOCK_WhenFlagClicked), loop, block(BLOCK_Stop)});
+        } else {
+            stack(blocks, {block(BLOCK_WhenFlagClicked), loop});
+        }
+        stack(blocks, {block(BLOCK_WhenReceive, 0, "ping"), block(BLOCK_ChangeVariable, 1, "pings")});
+    }
+}
+
+// A: set v to 5, B: set v to v + 1; C and D only move, so C and A share a
+// parallel run that must be committed before B reads v
+static void buildSetThenRead(GameState& gs, int) {
+    const char* names[] = {"C", "A", "B", "D"};
+    for (int i = 0; i < 4; i++) {
+        Sprite* sp = new Sprite();
+        sp->name = names[i];
+        gs.addSprite(sp);
+        Block* set = i == 1 ? block(BLOCK_SetVariable, 5, "v")
+                   : i == 2 ? block(BLOCK_SetVariable, 0, "v",
+                                    {block(BLOCK_Add, 0, "", {var("v"), lit(1)})})
+                            : block(BLOCK_ChangeX, 10);
+        stack(gs.scriptsOf(sp), {block(BLOCK_WhenFlagClicked), set});
+    }
+}
+
+struct EndState {
+    std::vector<std::string> vars;
+    std::vector<float>       x, y, direction;
+    std::vector<int>         layer;
+    size_t                   strokes;
+    int                      ticks;
+};
+
+static EndState run(void (*build)(GameState&, int), bool parallel, int sprites, int maxTicks) {
+    GameState gs;
+    build(gs, sprites);
+    gs.exec.parallel  = parallel;
+    gs.exec.passLimit = Engine::HEADLESS_PASSES;
+    srand(1);
+    Engine::startExecution(gs);
+    int ticks = 0;
+    while (gs.exec.running && ticks < maxTicks) {
+        Engine::update(gs, 1.0f / Engine::TICK_RATE);
+        ticks++;
+    }
+
+    EndState s;
+    for (const Value& v : gs.variables.values) s.vars.push_back(toString(v));
+    s.x         = gs.spriteData.x;
+    s.y         = gs.spriteData.y;
+    s.direction = gs.spriteData.direction;
+    s.layer     = gs.spriteData.layer;
+    s.strokes   = gs.penStrokes.size();
+    s.ticks     = ticks;
+    return s;
+}
+
+template <class T>
+static bool same(const char* what, const std::vector<T>& a, const std::vector<T>& b) {
+    if (a.size() != b.size()) {
+        printf("FAIL: %s: %zu entries serial, %zu parallel\n", what, a.size(), b.size());
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++)
+        if (!(a[i] == b[i])) {
+            printf("FAIL: %s[%zu] differs\n", what, i);
+            return false;
+        }
+    return true;
+}
+
+static bool compare(const EndState& serial, const EndState& parallel) {
+    bool ok = same("variable", serial.vars, parallel.vars) &&
+              same("x", serial.x, parallel.x) && same("y", serial.y, parallel.y) &&
+              same("direction", serial.direction, parallel.direction) &&
+              same("layer", serial.layer, parallel.layer);
+    if (ok && serial.strokes != parallel.strokes) {
+        printf("FAIL: %zu pen strokes serial, %zu parallel\n", serial.strokes, parallel.strokes);
+        ok = false;
+    }
+    if (ok && serial.ticks != parallel.ticks) {
+        printf("FAIL: finished after %d ticks serial, %d parallel\n", serial.ticks, parallel.ticks);
+        ok = false;
+    }
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    int sprites = argc > 1 ? std::atoi(argv[1]) : 300;
+    int ticks   = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    EndState serial   = run(buildSetThenRead, false, 0, ticks);
+    EndState parallel = run(buildSetThenRead, true,  0, ticks);
+    if (serial.vars != std::vector<std::string>{"6"}) {
+        printf("FAIL: set v to 5, set v to v + 1 gives %s serially\n",
+               serial.vars.empty() ? "nothing" : serial.vars[0].c_str());
+        return 1;
+    }
+    if (!compare(serial, parallel)) return 1;
+
+    serial   = run(buildProject, false, sprites, ticks);
+    parallel = run(buildProject, true,  sprites, ticks);
+    if (!compare(serial, parallel)) return 1;
+    printf("ok: %d sprites, %d ticks, serial and parallel end in the same state\n",
+           sprites, serial.ticks);
+    return 0;
+}
@@ -0,0 +1,100 @@
+// tracedump — print or filter a binary execution trace (see Trace.h)
+//
+//   g++ -std=c++17 -O2 -I.. tracedump.cpp -o tracedump
+//   tracedump trace.bin [--sprite N] [--op NAME] [--from TICK] [--to TICK]
+//                       [--limit N] [--csv]
+//
+// Records are printed oldest first; once the ring has wrapped only the
+// newest `capacity` records are left.
+#include "Trace.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void usage() {
+    std::cerr << "usage: tracedump FILE [--sprite N] [--op NAME] [--from TICK] [--to TICK]"
+                 " [--limit N] [--csv]\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) { usage(); return 2; }
+
+    std::string path = argv[1];
+    long        sprite = -1, limit = -1;
+    long long   from = 0, to = -1;
+    std::string opFilter;
+    bool        csv = false;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        bool more = i + 1 < argc;
+        if      (arg == "--sprite" && more) sprite   = std::atol(argv[++i]);
+        else if (arg == "--op"     && more) opFilter = argv[++i];
+        else if (arg == "--from"   && more) from     = std::atoll(argv[++i]);
+        else if (arg == "--to"     && more) to       = std::atoll(argv[++i]);
+        else if (arg == "--limit"  && more) limit    = std::atol(argv[++i]);
+        else if (arg == "--csv")            csv      = true;
+        else { usage(); return 2; }
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) { std::cerr << "cannot open " << path << "\n"; return 1; }
+
+    Trace::Header h;
+    if (!in.read((char*)&h, sizeof h) || memcmp(h.magic, Trace::MAGIC, sizeof h.magic) != 0) {
+        std::cerr << path << ": not a trace file\n";
+        return 1;
+    }
+    if (h.version != Trace::VERSION || h.recordSize != sizeof(Trace::Record)) {
+        std::cerr << path << ": unsupported trace version " << h.version << "\n";
+        return 1;
+    }
+
+    // Block type names
+    std::vector<char> blob(h.namesSize);
+    in.read(blob.data(), blob.size());
+    std::vector<std::string> names;
+    for (size_t p = 0; names.size() < h.nameCount && p < blob.size(); ) {
+        names.emplace_back(&blob[p]);
+        p += names.back().size() + 1;
+    }
+    auto opName = [&](int op) {
+        if (op < (int)names.size() && !names[op].empty()) return names[op];
+        return "op" + std::to_string(op);
+    };
+
+    // Oldest surviving record first
+    uint64_t count = h.written < h.capacity ? h.written : h.capacity;
+    uint64_t first = h.written - count;
+
+    if (csv) std::cout << "seq,tick,sprite,script,pc,op,num0,num1\n";
+    long printed = 0;
+    Trace::Record r;
+    for (uint64_t n = first; n < h.written; n++) {
+        if (limit >= 0 && printed >= limit) break;
+        in.seekg((std::streamoff)(h.recordsOffset + (n % h.capacity) * sizeof r));
+        if (!in.read((char*)&r, sizeof r)) break;
+
+        if (sprite >= 0 && r.sprite != sprite)             continue;
+        if (r.tick < from || (to >= 0 && r.tick > to))    continue;
+        std::string op = opName(r.op);
+        if (!opFilter.empty() && op != opFilter)           continue;
+
+        if (csv)
+            printf("%llu,%u,%u,%d,%d,%s,%g,%g\n", (unsigned long long)n, r.tick, r.sprite,
+                   r.script, r.pc, op.c_str(), r.num[0], r.num[1]);
+        else
+            printf("#%-8llu tick %-6u sprite %-3u script %-3d pc %-5d %-18s %g %g\n",
+                   (unsigned long long)n, r.tick, r.sprite, r.script, r.pc, op.c_str(),
+                   r.num[0], r.num[1]);
+        printed++;
+    }
+
+    std::cerr << printed << " of " << count << " record(s)";
+    if (h.written > h.capacity) std::cerr << " (" << h.written - count << " overwritten)";
+    std::cerr << "\n";
+    return 0;
+}